@@ -0,0 +1,114 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include "ai.h"
+
+/*
+    Weights of the heuristic (from the genetic algorithm tuned bot of Yiyuan Lee)
+*/
+#define AI_HEIGHT_WEIGHT (-0.510066)
+#define AI_LINES_WEIGHT 0.760666
+#define AI_HOLES_WEIGHT (-0.35663)
+#define AI_BUMPINESS_WEIGHT (-0.184483)
+
+/*
+    Value of a placement that ends the game
+*/
+#define AI_LOST_VALUE (-1.0e9)
+
+/*
+    Key of a position searched at a given depth, so that different depths do not collide
+*/
+#define AI_TT_KEY(game, depth) (Game_position_hash(game) ^ ((uint64_t)(depth) * 0xD6E8FEB86659FD93ull))
+
+double Ai_evaluate(const Game* game, int deleted_rows)
+{
+    int aggregate_height = 0;
+    int holes = 0;
+    int bumpiness = 0;
+    int previous_height = -1;
+
+    for (int col = 0; col < COLS; ++col) {
+        int height = 0;
+        for (int row = 0; row < TOTAL_ROWS; ++row) {
+            if (game->board[row][col].active) {
+                if (height == 0) {
+                    height = TOTAL_ROWS - row;
+                }
+            } else if (height != 0) {
+                holes += 1;
+            }
+        }
+
+        aggregate_height += height;
+        if (previous_height >= 0) {
+            bumpiness += height > previous_height ? height - previous_height : previous_height - height;
+        }
+        previous_height = height;
+    }
+
+    return AI_HEIGHT_WEIGHT * aggregate_height
+        + AI_LINES_WEIGHT * deleted_rows
+        + AI_HOLES_WEIGHT * holes
+        + AI_BUMPINESS_WEIGHT * bumpiness;
+}
+
+double Ai_search(Ai* ai, const Game* game, int depth, Placement* best)
+{
+    assert(depth >= 1);
+
+    // The root needs the move, so only the inner positions go through the table
+    TTData cached = { 0 };
+    if (best == nullptr && ai->table != nullptr && TranspositionTable_probe(ai->table, AI_TT_KEY(game, depth), &cached) && cached.depth == depth) {
+        return cached.value;
+    }
+
+    double best_value = AI_LOST_VALUE;
+    Placement best_placement = { 0 };
+
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        for (int column = 0; column < COLS; ++column) {
+            Game after = *game;
+            if (!Game_place_active_piece(&after, rotation, column)) {
+                continue;
+            }
+
+            Game_release_active_piece(&after);
+            int deleted_rows = Game_delete_full_rows_if_exists(&after);
+            if (Game_check_game_over(&after)) {
+                continue;
+            }
+
+            double value = depth > 1
+                ? AI_LINES_WEIGHT * deleted_rows + Ai_search(ai, &after, depth - 1, nullptr)
+                : Ai_evaluate(&after, deleted_rows);
+
+            if (value > best_value) {
+                best_value = value;
+                best_placement = (Placement) { .rotation = rotation, .column = column };
+            }
+        }
+    }
+
+    if (best != nullptr) {
+        *best = best_placement;
+    } else if (ai->table != nullptr) {
+        TTData data = {
+            .value = best_value,
+            .depth = (uint8_t)depth,
+            .move = (uint8_t)(best_placement.rotation * COLS + best_placement.column),
+        };
+        TranspositionTable_store(ai->table, AI_TT_KEY(game, depth), data);
+    }
+
+    return best_value;
+}
+
+bool Ai_best_placement(Ai* ai, const Game* game, Placement* best)
+{
+    // The positions of the last search were followed by other pieces
+    if (ai->table != nullptr) {
+        TranspositionTable_new_generation(ai->table);
+    }
+    return Ai_search(ai, game, ai->lookahead < 1 ? 1 : ai->lookahead, best) > AI_LOST_VALUE;
+}
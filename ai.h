@@ -0,0 +1,43 @@
+#ifndef AI_H_
+#define AI_H_
+
+#include "game.h"
+
+/*
+    Where to put the active piece: number of clockwise rotations from the spawn position
+    and column of its most left square
+*/
+typedef struct {
+    int rotation;
+    int column;
+} Placement;
+
+/*
+    Heuristic bot (aggregate height, holes, bumpiness and cleared lines).
+    lookahead 1 looks only at the active piece, 2 also at the next piece.
+    The transposition table (may be nullptr) deduplicates the boards reached by different
+    placements within a search, so equivalent stacks are evaluated only once. It stores
+    the exact values: the bot plays the same moves with or without it
+*/
+typedef struct {
+    int lookahead;
+    TranspositionTable* table;
+} Ai;
+
+/*
+    Start a new generation of the table and search. Return false if there is no placement
+    that does not end the game
+*/
+bool Ai_best_placement(Ai* ai, const Game* game, Placement* best);
+
+/*
+    Value of the board after a placement that deleted deleted_rows rows (higher is better)
+*/
+double Ai_evaluate(const Game* game, int deleted_rows);
+
+/*
+    Best value reachable from game looking depth pieces ahead
+*/
+double Ai_search(Ai* ai, const Game* game, int depth, Placement* best);
+
+#endif // AI_H_
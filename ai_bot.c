@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ai.h"
+#include "bot.h"
+#include "game.h"
+
+/*
+    cetris-bot: the heuristic AI speaking the bot protocol of bot.h on stdin/stdout.
+    Run the game against it with: ./cetris --bot "./cetris-bot 2"
+    The optional argument is the lookahead (1 or 2, default 2)
+*/
+
+#define TT_LOG2_ENTRIES 16
+
+/*
+    Answer a suggest for the active piece of game
+*/
+void suggest(Ai* ai, const Game* game, uint32_t id);
+
+int main(int argc, char** argv)
+{
+    TranspositionTable table = { 0 };
+    Ai ai = {
+        .lookahead = argc > 1 ? atoi(argv[1]) : 2,
+        .table = TranspositionTable_init(&table, TT_LOG2_ENTRIES) ? &table : nullptr,
+    };
+    if (ai.lookahead < 1 || ai.lookahead > 2) {
+        fprintf(stderr, "Usage: %s [lookahead 1|2]\n", argv[0]);
+        return 1;
+    }
+
+    // Only the board and the pieces are used, the rest of the game is not known. The
+    // queue is the preview of the game followed by random kinds
+    Game game = Game_init(0, 0, Uniform);
+    PieceKind preview[PREVIEW_MAX] = { 0 };
+    int preview_length = 0;
+
+    printf("ready cetris-ai\n");
+    fflush(stdout);
+
+    char line[BOT_LINE_MAX];
+    while (fgets(line, sizeof(line), stdin) != nullptr) {
+        uint32_t id = 0;
+        int rotation = 0;
+        int column = 0;
+        char active = 0;
+        char next = 0;
+        char kinds[PREVIEW_MAX + 1];
+        char board[BOT_BOARD_CHARS + 1];
+
+        if (sscanf(line, "start %u %c %7s %220s", &id, &active, kinds, board) == 4) {
+            if (!Board_from_string(&game.board, board, T) || PieceKind_from_char(active) == Empty) {
+                continue;
+            }
+            preview_length = 0;
+            for (int i = 0; kinds[i] != '\0' && PieceKind_from_char(kinds[i]) != Empty; ++i) {
+                preview[preview_length++] = PieceKind_from_char(kinds[i]);
+            }
+            game.active_piece = Piece_spawn(PieceKind_from_char(active));
+            Game_set_upcoming(&game, preview, preview_length);
+            game.hash = Game_compute_hash(&game);
+            Game_compute_column_tops(&game);
+        } else if (sscanf(line, "suggest %u", &id) == 1) {
+            suggest(&ai, &game, id);
+        } else if (sscanf(line, "play %u %d %d", &id, &rotation, &column) == 3) {
+            // The first kind of the preview becomes active, new_piece follows
+            Game_place_active_piece(&game, rotation, column);
+            Game_lock_active_piece(&game, 0, nullptr);
+            if (preview_length > 0) {
+                memmove(preview, preview + 1, (size_t)(preview_length - 1) * sizeof(PieceKind));
+                preview_length -= 1;
+            }
+        } else if (sscanf(line, "new_piece %c", &next) == 1 && PieceKind_from_char(next) != Empty && preview_length < PREVIEW_MAX) {
+            preview[preview_length++] = PieceKind_from_char(next);
+            Game_set_upcoming(&game, preview, preview_length);
+        } else if (strncmp(line, "quit", 4) == 0) {
+            break;
+        }
+    }
+
+    TranspositionTable_free(&table);
+    return 0;
+}
+
+void suggest(Ai* ai, const Game* game, uint32_t id)
+{
+    Placement placement = { 0 };
+    if (!Ai_best_placement(ai, game, &placement)) {
+        // Lost anyway: drop it where it is
+        Piece piece = game->active_piece;
+        placement.rotation = 0;
+        placement.column = Piece_left_square(&piece);
+    }
+    printf("move %u %d %d\n", id, placement.rotation, placement.column);
+    fflush(stdout);
+}
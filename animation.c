@@ -0,0 +1,97 @@
+#include <string.h>
+
+#include "animation.h"
+
+void Timeline_advance(Timeline* timeline, float delta_time)
+{
+    timeline->time += delta_time;
+
+    int kept = 0;
+    for (int i = 0; i < timeline->count; ++i) {
+        if (AnimationEvent_progress(&timeline->events[i], timeline->time) < 1.0f) {
+            timeline->events[kept++] = timeline->events[i];
+        }
+    }
+    timeline->count = kept;
+
+    // Nothing to draw: restart the clock before it loses precision
+    if (timeline->count == 0) {
+        timeline->time = 0.0f;
+    }
+}
+
+void Timeline_clear(Timeline* timeline)
+{
+    timeline->time = 0.0f;
+    timeline->count = 0;
+}
+
+void Timeline_add_line_clear(Timeline* timeline, const Game* game)
+{
+    AnimationEvent event = {
+        .kind = LineClear,
+        .start = timeline->time,
+    };
+    event.row_count = Game_rows_filled_by_active_piece(game, event.rows);
+    if (event.row_count == 0) {
+        return;
+    }
+    event.duration = event.row_count == 4 ? TETRIS_CLEAR_DURATION : LINE_CLEAR_DURATION;
+
+    for (int i = 0; i < event.row_count; ++i) {
+        memcpy(event.cleared[i], game->board[event.rows[i]], sizeof(event.cleared[i]));
+    }
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        for (int j = 0; j < event.row_count; ++j) {
+            if (game->active_piece.squares[i][0] == event.rows[j]) {
+                event.cleared[j][game->active_piece.squares[i][1]] = (Slot) { .active = true, .type = game->active_piece.kind };
+            }
+        }
+    }
+
+    // A kept row falls by the deleted rows below it, the new empty rows on top by all of them
+    int below = 0;
+    int deleted = event.row_count - 1;
+    for (int row = game->rows + HIDDEN_ROWS - 1; row >= 0; --row) {
+        if (deleted >= 0 && event.rows[deleted] == row) {
+            below += 1;
+            deleted -= 1;
+        } else {
+            event.shift[row + below] = below;
+        }
+    }
+    for (int row = 0; row < event.row_count; ++row) {
+        event.shift[row] = event.row_count;
+    }
+
+    if (timeline->count == TIMELINE_MAX_EVENTS) {
+        memmove(timeline->events, timeline->events + 1, (TIMELINE_MAX_EVENTS - 1) * sizeof(AnimationEvent));
+        timeline->count -= 1;
+    }
+    timeline->events[timeline->count++] = event;
+}
+
+float AnimationEvent_progress(const AnimationEvent* event, float time)
+{
+    float progress = (time - event->start) / event->duration;
+    return progress < 0.0f ? 0.0f : progress > 1.0f ? 1.0f : progress;
+}
+
+float Timeline_row_offset(const Timeline* timeline, int row)
+{
+    float offset = 0.0f;
+
+    for (int i = 0; i < timeline->count; ++i) {
+        const AnimationEvent* event = &timeline->events[i];
+        if (event->kind != LineClear) {
+            continue;
+        }
+
+        float progress = AnimationEvent_progress(event, timeline->time);
+        float fall = progress < LINE_CLEAR_FALL_START ? 0.0f : (progress - LINE_CLEAR_FALL_START) / (1.0f - LINE_CLEAR_FALL_START);
+        // Ease in: the rows accelerate like they are falling
+        offset += (float)event->shift[row] * (1.0f - fall * fall);
+    }
+
+    return offset;
+}
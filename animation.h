@@ -0,0 +1,66 @@
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include "game.h"
+
+/*
+    Visual effects of the game, kept outside Game: the simulation applies everything
+    instantly (rows are deleted in the same tick), the timeline only remembers what
+    happened and for how long it has to be drawn. It advances with the frame time, so it
+    never stalls the logic, the input, the replays or the bots.
+*/
+
+#define TIMELINE_MAX_EVENTS 8
+#define LINE_CLEAR_DURATION 0.3f
+#define TETRIS_CLEAR_DURATION 0.5f
+// Part of a line clear spent on the deleted rows, then the rows above fall
+#define LINE_CLEAR_FALL_START 0.5f
+
+typedef enum {
+    LineClear,
+} AnimationKind;
+
+typedef struct {
+    AnimationKind kind;
+    float start; // timeline time of the event
+    float duration;
+
+    // LineClear
+    int rows[4]; // deleted rows, top to bottom, as they were before the deletion
+    int row_count;
+    Slot cleared[4][COLS_MAX]; // content of the deleted rows
+    int shift[TOTAL_ROWS_MAX]; // rows every row of the new board fell because of the deletion
+} AnimationEvent;
+
+typedef struct {
+    float time;
+    AnimationEvent events[TIMELINE_MAX_EVENTS];
+    int count;
+} Timeline;
+
+/*
+    Move the timeline forward by delta_time and drop the events that are over
+*/
+void Timeline_advance(Timeline* timeline, float delta_time);
+
+void Timeline_clear(Timeline* timeline);
+
+/*
+    Record the rows that the active piece of game is going to delete when locked. Call it
+    right before Game_lock_active_piece, it does nothing if no row is deleted. The oldest
+    event is dropped when the timeline is full
+*/
+void Timeline_add_line_clear(Timeline* timeline, const Game* game);
+
+/*
+    From 0 (just started) to 1 (over)
+*/
+float AnimationEvent_progress(const AnimationEvent* event, float time);
+
+/*
+    How many rows above its place a row of the board has to be drawn, while the rows
+    above deleted lines fall down
+*/
+float Timeline_row_offset(const Timeline* timeline, int row);
+
+#endif // ANIMATION_H_
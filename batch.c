@@ -0,0 +1,369 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+
+/*
+    Every array of the batch starts on its own cache line
+*/
+#define BATCH_ALIGN 64
+#define BATCH_ALIGN_UP(size) (((size) + BATCH_ALIGN - 1) & ~(size_t)(BATCH_ALIGN - 1))
+
+/*
+    Macro: collision test of a shape with the pivot in (row, col) against the board of
+    game. No bound checks: the walls and the padding rows are always occupied
+*/
+#define BATCH_HIT(rows, count, game, shape, row, col)                                           \
+    ((((uint32_t)(rows)[((row) + (shape)->top + BATCH_PAD + 0) * (count) + (game)]               \
+          & ((uint32_t)(shape)->mask[0] << ((col) + (shape)->left + BATCH_WALL)))                \
+         | ((uint32_t)(rows)[((row) + (shape)->top + BATCH_PAD + 1) * (count) + (game)]          \
+             & ((uint32_t)(shape)->mask[1] << ((col) + (shape)->left + BATCH_WALL)))             \
+         | ((uint32_t)(rows)[((row) + (shape)->top + BATCH_PAD + 2) * (count) + (game)]          \
+             & ((uint32_t)(shape)->mask[2] << ((col) + (shape)->left + BATCH_WALL)))             \
+         | ((uint32_t)(rows)[((row) + (shape)->top + BATCH_PAD + 3) * (count) + (game)]          \
+             & ((uint32_t)(shape)->mask[3] << ((col) + (shape)->left + BATCH_WALL))))            \
+        != 0)
+
+/*
+    Build the 4 rotations of every kind from Piece_spawn and the Piece_rotate rule
+    (clockwise: (row, col) offsets from the pivot become (-col, row))
+*/
+void GameBatch_build_shapes(GameBatch* batch);
+
+/*
+    Move the active piece of game according to its action
+*/
+void GameBatch_apply_action(GameBatch* batch, int game, uint8_t action);
+
+/*
+    Write the active piece squares of game into its board
+*/
+void GameBatch_lock(GameBatch* batch, int game);
+
+/*
+    Delete the full rows of game, exactly like Game_delete_full_rows_if_exists
+*/
+void GameBatch_delete_full_rows(GameBatch* batch, int game);
+
+/*
+    Put the next piece in play and draw a new next kind, set done if it does not fit
+*/
+void GameBatch_spawn(GameBatch* batch, int game);
+
+bool GameBatch_init(GameBatch* batch, int count, Randomizer randomizer)
+{
+    assert(count > 0);
+    memset(batch, 0, sizeof(*batch));
+    batch->count = count;
+    batch->randomizer = randomizer;
+    GameBatch_build_shapes(batch);
+
+    size_t n = (size_t)count;
+    size_t sizes[] = {
+        BATCH_ROWS * n * sizeof(uint16_t), // rows
+        n * sizeof(uint8_t), // kind
+        n * sizeof(uint8_t), // rotation
+        n * sizeof(int8_t), // piece_row
+        n * sizeof(int8_t), // piece_col
+        n * sizeof(uint8_t), // next_kind
+        n * sizeof(Rng), // rng
+        n * Empty * sizeof(PieceKind), // bags
+        n * sizeof(int), // bag_size
+        n * sizeof(int32_t), // score
+        n * sizeof(int32_t), // lines
+        n * sizeof(int32_t), // level
+        n * sizeof(int32_t), // start_level
+        n * sizeof(uint8_t), // landed
+        n * sizeof(uint8_t), // cleared
+        n * sizeof(uint8_t), // done
+    };
+
+    size_t total = 0;
+    for (int i = 0; i < ARRAY_LEN_INT(sizes); ++i) {
+        total += BATCH_ALIGN_UP(sizes[i]);
+    }
+    batch->memory = aligned_alloc(BATCH_ALIGN, total);
+    if (batch->memory == nullptr) {
+        return false;
+    }
+    memset(batch->memory, 0, total);
+
+    void** arrays[] = {
+        (void**)&batch->rows,
+        (void**)&batch->kind,
+        (void**)&batch->rotation,
+        (void**)&batch->piece_row,
+        (void**)&batch->piece_col,
+        (void**)&batch->next_kind,
+        (void**)&batch->rng,
+        (void**)&batch->bags,
+        (void**)&batch->bag_size,
+        (void**)&batch->score,
+        (void**)&batch->lines,
+        (void**)&batch->level,
+        (void**)&batch->start_level,
+        (void**)&batch->landed,
+        (void**)&batch->cleared,
+        (void**)&batch->done,
+    };
+    static_assert(ARRAY_LEN_INT(arrays) == ARRAY_LEN_INT(sizes), "One size for every array");
+
+    uint8_t* cursor = batch->memory;
+    for (int i = 0; i < ARRAY_LEN_INT(arrays); ++i) {
+        *arrays[i] = cursor;
+        cursor += BATCH_ALIGN_UP(sizes[i]);
+    }
+
+    // Every row is full (so a done game collides everywhere) until the game is reset
+    for (size_t i = 0; i < BATCH_ROWS * n; ++i) {
+        batch->rows[i] = BATCH_FULL_ROW;
+    }
+    memset(batch->done, 1, n);
+
+    return true;
+}
+
+void GameBatch_free(GameBatch* batch)
+{
+    free(batch->memory);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void GameBatch_build_shapes(GameBatch* batch)
+{
+    for (int kind = 0; kind < Empty; ++kind) {
+        Piece piece = Piece_spawn((PieceKind)kind);
+        batch->spawn_row[kind] = (int8_t)piece.squares[1][0];
+        batch->spawn_col[kind] = (int8_t)piece.squares[1][1];
+
+        int offsets[4][2] = { 0 };
+        for (int i = 0; i < 4; ++i) {
+            offsets[i][0] = piece.squares[i][0] - piece.squares[1][0];
+            offsets[i][1] = piece.squares[i][1] - piece.squares[1][1];
+        }
+
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            PieceShape* shape = &batch->shapes[kind][rotation];
+            int top = 0, left = 0;
+            for (int i = 0; i < 4; ++i) {
+                top = offsets[i][0] < top ? offsets[i][0] : top;
+                left = offsets[i][1] < left ? offsets[i][1] : left;
+            }
+
+            *shape = (PieceShape) { .top = (int8_t)top, .left = (int8_t)left };
+            for (int i = 0; i < 4; ++i) {
+                assert(offsets[i][0] - top < 4 && offsets[i][1] - left < 4);
+                shape->mask[offsets[i][0] - top] |= (uint16_t)(1u << (offsets[i][1] - left));
+            }
+
+            for (int i = 0; i < 4; ++i) {
+                int row = offsets[i][0];
+                offsets[i][0] = -offsets[i][1];
+                offsets[i][1] = row;
+            }
+        }
+    }
+}
+
+void GameBatch_reset(GameBatch* batch, int game, int level, uint64_t seed)
+{
+    int n = batch->count;
+    for (int row = 0; row < BATCH_ROWS; ++row) {
+        bool padding = row < BATCH_PAD || row >= BATCH_PAD + TOTAL_ROWS;
+        batch->rows[row * n + game] = padding ? BATCH_FULL_ROW : BATCH_EMPTY_ROW;
+    }
+
+    batch->rng[game] = Rng_seed(seed);
+    PieceKind* bag = &batch->bags[game * Empty];
+    for (int i = 0; i < Empty; ++i) {
+        bag[i] = Empty;
+    }
+    batch->bag_size[game] = 0;
+
+    batch->score[game] = 0;
+    batch->lines[game] = 0;
+    batch->level[game] = level;
+    batch->start_level[game] = level;
+    batch->landed[game] = 0;
+    batch->cleared[game] = 0;
+    batch->done[game] = 0;
+
+    // Same draws as Game_init: the active kind, then the next one
+    PieceKind active = Randomizer_next(batch->randomizer, &batch->rng[game], bag, &batch->bag_size[game], Empty);
+    batch->next_kind[game] = (uint8_t)active;
+    GameBatch_spawn(batch, game);
+}
+
+bool GameBatch_collides(const GameBatch* batch, int game, int kind, int rotation, int row, int col)
+{
+    const PieceShape* shape = &batch->shapes[kind][rotation];
+    return BATCH_HIT(batch->rows, batch->count, game, shape, row, col);
+}
+
+bool GameBatch_is_occupied(const GameBatch* batch, int game, int row, int col)
+{
+    return (batch->rows[(row + BATCH_PAD) * batch->count + game] >> (col + BATCH_WALL)) & 1;
+}
+
+void GameBatch_active_squares(const GameBatch* batch, int game, Square squares[4])
+{
+    const PieceShape* shape = &batch->shapes[batch->kind[game]][batch->rotation[game]];
+    int found = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int bit = 0; bit < 4; ++bit) {
+            if ((shape->mask[i] >> bit) & 1) {
+                squares[found][0] = batch->piece_row[game] + shape->top + i;
+                squares[found][1] = batch->piece_col[game] + shape->left + bit;
+                found += 1;
+            }
+        }
+    }
+    assert(found == 4);
+}
+
+void GameBatch_apply_action(GameBatch* batch, int game, uint8_t action)
+{
+    int n = batch->count;
+    int kind = batch->kind[game];
+    int row = batch->piece_row[game];
+    int col = batch->piece_col[game];
+    int rotation = batch->rotation[game];
+
+    if (action == HardDrop) {
+        const PieceShape* shape = &batch->shapes[kind][rotation];
+        while (!BATCH_HIT(batch->rows, n, game, shape, row + 1, col)) {
+            row += 1;
+        }
+        batch->piece_row[game] = (int8_t)row;
+        return;
+    }
+
+    // Branch free candidate position, kept only if it does not collide
+    int new_col = col + (action == MoveRight) - (action == MoveLeft);
+    int new_row = row + (action == SoftDrop);
+    int new_rotation = (rotation + (action == RotateRight) + 3 * (action == RotateLeft)) & 3;
+    const PieceShape* shape = &batch->shapes[kind][new_rotation];
+    bool free = !BATCH_HIT(batch->rows, n, game, shape, new_row, new_col);
+
+    batch->piece_col[game] = (int8_t)(free ? new_col : col);
+    batch->piece_row[game] = (int8_t)(free ? new_row : row);
+    batch->rotation[game] = (uint8_t)(free ? new_rotation : rotation);
+}
+
+void GameBatch_lock(GameBatch* batch, int game)
+{
+    int n = batch->count;
+    const PieceShape* shape = &batch->shapes[batch->kind[game]][batch->rotation[game]];
+    int top = batch->piece_row[game] + shape->top + BATCH_PAD;
+    int shift = batch->piece_col[game] + shape->left + BATCH_WALL;
+
+    for (int i = 0; i < 4; ++i) {
+        batch->rows[(top + i) * n + game] |= (uint16_t)(shape->mask[i] << shift);
+    }
+}
+
+void GameBatch_delete_full_rows(GameBatch* batch, int game)
+{
+    int n = batch->count;
+    uint16_t* rows = batch->rows + BATCH_PAD * n + game;
+
+    // Same algorithm of Game_delete_full_rows_if_exists (row 0 is copied, not emptied),
+    // it runs only for the few games that actually cleared something
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        if (rows[row * n] == BATCH_FULL_ROW) {
+            for (int row_start = row; row_start > 0; --row_start) {
+                rows[row_start * n] = rows[(row_start - 1) * n];
+            }
+        }
+    }
+}
+
+void GameBatch_spawn(GameBatch* batch, int game)
+{
+    int kind = batch->next_kind[game];
+    batch->kind[game] = (uint8_t)kind;
+    batch->rotation[game] = 0;
+    batch->piece_row[game] = batch->spawn_row[kind];
+    batch->piece_col[game] = batch->spawn_col[kind];
+
+    PieceKind* bag = &batch->bags[game * Empty];
+    batch->next_kind[game] = (uint8_t)Randomizer_next(batch->randomizer, &batch->rng[game], bag, &batch->bag_size[game], (PieceKind)kind);
+}
+
+void GameBatch_step(GameBatch* batch, const uint8_t* actions)
+{
+    GameBatch_step_range(batch, actions, 0, batch->count);
+}
+
+void GameBatch_step_range(GameBatch* batch, const uint8_t* actions, int first, int last)
+{
+    int n = batch->count;
+    assert(0 <= first && first <= last && last <= n);
+
+    // The boards and done are also written by the helpers below, through batch: only the
+    // arrays written here alone are restrict
+    uint16_t* rows = batch->rows;
+    uint8_t* restrict landed = batch->landed;
+    uint8_t* restrict cleared = batch->cleared;
+    const uint8_t* done = batch->done;
+
+    // 1. Actions
+    for (int game = first; game < last; ++game) {
+        if (!done[game]) {
+            GameBatch_apply_action(batch, game, actions[game - first]);
+        }
+    }
+
+    // 2. Gravity: gather the 4 rows under every piece, move down or mark it as landed.
+    // Branch free but scalar: every game reads other rows, the compilers do not vectorize
+    // the gather (neither the actions nor the lock)
+    for (int game = first; game < last; ++game) {
+        const PieceShape* shape = &batch->shapes[batch->kind[game]][batch->rotation[game]];
+        bool hit = BATCH_HIT(rows, n, game, shape, batch->piece_row[game] + 1, batch->piece_col[game]);
+        landed[game] = (uint8_t)(hit & !done[game]);
+        batch->piece_row[game] += (int8_t)(!hit & !done[game]);
+        cleared[game] = 0;
+    }
+
+    // 3. Lock the landed pieces
+    for (int game = first; game < last; ++game) {
+        if (landed[game]) {
+            GameBatch_lock(batch, game);
+        }
+    }
+
+    // 4. Full rows of all the games at once: every row is a contiguous vector of games.
+    // The only pass that vectorizes, with the vectors of the baseline target (SSE2 on
+    // x86-64, NEON on arm64, simd128 on the web): the build passes no -march
+    for (int row = BATCH_PAD; row < BATCH_PAD + TOTAL_ROWS; ++row) {
+        const uint16_t* restrict line = rows + row * n;
+        for (int game = first; game < last; ++game) {
+            cleared[game] += (uint8_t)(line[game] == BATCH_FULL_ROW);
+        }
+    }
+
+    // 5. Compaction, score, level and next piece only where something happened
+    for (int game = first; game < last; ++game) {
+        if (!landed[game]) {
+            cleared[game] = 0;
+            continue;
+        }
+
+        if (cleared[game] > 0) {
+            GameBatch_delete_full_rows(batch, game);
+        }
+        GameBatch_spawn(batch, game);
+
+        batch->lines[game] += cleared[game];
+        batch->score[game] += Score_for_lines(cleared[game], batch->level[game]);
+        if (Level_is_completed(batch->level[game], batch->start_level[game], batch->lines[game])) {
+            batch->level[game] += 1;
+        }
+
+        const PieceShape* shape = &batch->shapes[batch->kind[game]][0];
+        if (BATCH_HIT(rows, n, game, shape, batch->piece_row[game], batch->piece_col[game])) {
+            batch->done[game] = 1;
+        }
+    }
+}
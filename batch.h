@@ -0,0 +1,132 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+    A GameBatch steps thousands of games in lockstep (for RL training). Boards are
+    bitboards: one uint16_t per row, column c is bit (c + BATCH_WALL) and the bits outside
+    the board are always set, so the walls collide like any other square. BATCH_PAD full
+    rows above and below the board make the ceiling and the floor collide too, so a
+    collision test is just 4 loads, 4 shifts and 4 ands, without bound checks.
+
+    Everything is stored as structure of arrays: rows[row * count + game], so the same row
+    of all the games is contiguous and the full-row detection is a straight vector loop.
+    The rest of the step (actions, gravity, lock) is branch free but scalar: the rows that a
+    piece touches are at a different place for every game.
+
+    The rules are the same as Game (same spawn positions, rotations without kicks around
+    the second square, scoring, levels and randomizers), only the kinds of the locked
+    squares are not kept.
+*/
+
+#define BATCH_WALL 3
+#define BATCH_PAD 4
+#define BATCH_ROWS (TOTAL_ROWS + 2 * BATCH_PAD)
+#define BATCH_EMPTY_ROW ((uint16_t)~(((1u << COLS) - 1) << BATCH_WALL))
+#define BATCH_FULL_ROW ((uint16_t)0xFFFF)
+
+/*
+    What a game does in a step, before the gravity
+*/
+typedef enum {
+    NoAction,
+    MoveLeft,
+    MoveRight,
+    RotateLeft,
+    RotateRight,
+    SoftDrop,
+    HardDrop,
+    ActionCount
+} Action;
+
+/*
+    Bounding box of a piece in a rotation, relative to its pivot (the second square of
+    the spawn piece, the one Piece_rotate rotates around)
+*/
+typedef struct {
+    int8_t top;
+    int8_t left;
+    uint16_t mask[4]; // rows of the box, bit 0 is the left column of the box
+} PieceShape;
+
+typedef struct {
+    int count;
+    Randomizer randomizer;
+    PieceShape shapes[Empty][4];
+    int8_t spawn_row[Empty];
+    int8_t spawn_col[Empty];
+
+    // Boards
+    uint16_t* rows;
+
+    // Active piece
+    uint8_t* kind;
+    uint8_t* rotation;
+    int8_t* piece_row;
+    int8_t* piece_col;
+    uint8_t* next_kind;
+
+    // Randomizer
+    Rng* rng;
+    PieceKind* bags; // Empty kinds for every game
+    int* bag_size;
+
+    // Counters
+    int32_t* score;
+    int32_t* lines;
+    int32_t* level;
+    int32_t* start_level;
+
+    // Result of the last step
+    uint8_t* landed;
+    uint8_t* cleared;
+    uint8_t* done;
+
+    void* memory;
+} GameBatch;
+
+/*
+    Allocate count games (all of them done until reset). Return false if the allocation fails
+*/
+bool GameBatch_init(GameBatch* batch, int count, Randomizer randomizer);
+void GameBatch_free(GameBatch* batch);
+
+/*
+    Start a new game in slot game, like Game_init(level, seed, batch->randomizer)
+*/
+void GameBatch_reset(GameBatch* batch, int game, int level, uint64_t seed);
+
+/*
+    Apply actions[game] to every game that is not done, then move every active piece down
+    by one row. Pieces that touch are locked, full rows deleted and the next piece spawned.
+    After the step landed, cleared (deleted rows) and done are up to date for every game
+*/
+void GameBatch_step(GameBatch* batch, const uint8_t* actions);
+
+/*
+    Same as GameBatch_step but only for the games in [first, last), actions[0] is the
+    action of game first
+*/
+void GameBatch_step_range(GameBatch* batch, const uint8_t* actions, int first, int last);
+
+/*
+    True if the piece (kind, rotation) with the pivot in (row, col) overlaps the board
+    or goes out of it
+*/
+bool GameBatch_collides(const GameBatch* batch, int game, int kind, int rotation, int row, int col);
+
+/*
+    True if the board square is occupied
+*/
+bool GameBatch_is_occupied(const GameBatch* batch, int game, int row, int col);
+
+/*
+    Write the 4 squares of the active piece of game, in row major order (the order of the
+    squares of a Piece is not kept)
+*/
+void GameBatch_active_squares(const GameBatch* batch, int game, Square squares[4]);
+
+#endif // BATCH_H_
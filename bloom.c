@@ -0,0 +1,158 @@
+#include <math.h>
+
+#include "bloom.h"
+
+/*
+    Draw from into to, stretched, with shader (none if its id is 0). Render textures are
+    upside down, drawing them with a negative height keeps every pass the same way up
+*/
+void Bloom_pass(RenderTexture2D from, RenderTexture2D to, Shader shader);
+
+/*
+    Load a render texture filtered linearly and clamped on the edges, as the blur samples
+    between and past the pixels
+*/
+RenderTexture2D Bloom_target(int width, int height);
+
+void Bloom_init(Bloom* bloom, Rectangle area, float zoom, int level_count)
+{
+    *bloom = (Bloom) { .area = area, .zoom = zoom };
+    int width = (int)roundf(area.width * zoom);
+    int height = (int)roundf(area.height * zoom);
+    if (level_count < 0) {
+        level_count = 0;
+    }
+    if (level_count > BLOOM_LEVELS_MAX) {
+        level_count = BLOOM_LEVELS_MAX;
+    }
+    while (level_count > 0 && ((width >> level_count) < 1 || (height >> level_count) < 1)) {
+        --level_count;
+    }
+    if (level_count == 0) {
+        return;
+    }
+
+#ifdef __EMSCRIPTEN__
+    bloom->bright = LoadShader("resources/shaders/liquid_square_vertex.glsl", "resources/shaders/bloom_bright_web.glsl");
+    bloom->blur = LoadShader("resources/shaders/liquid_square_vertex.glsl", "resources/shaders/bloom_blur_web.glsl");
+#else
+    bloom->bright = LoadShader(nullptr, "resources/shaders/bloom_bright.glsl");
+    bloom->blur = LoadShader(nullptr, "resources/shaders/bloom_blur.glsl");
+#endif
+    bloom->threshold_loc = GetShaderLocation(bloom->bright, "threshold");
+    bloom->direction_loc = GetShaderLocation(bloom->blur, "direction");
+    float threshold = BLOOM_THRESHOLD;
+    SetShaderValue(bloom->bright, bloom->threshold_loc, &threshold, SHADER_UNIFORM_FLOAT);
+
+    bloom->scene = Bloom_target(width, height);
+    for (int i = 0; i < level_count; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            bloom->levels[i][j] = Bloom_target(width >> (i + 1), height >> (i + 1));
+        }
+    }
+    bloom->level_count = level_count;
+}
+
+void Bloom_free(Bloom* bloom)
+{
+    if (bloom->level_count == 0) {
+        return;
+    }
+    UnloadShader(bloom->bright);
+    UnloadShader(bloom->blur);
+    UnloadRenderTexture(bloom->scene);
+    for (int i = 0; i < bloom->level_count; ++i) {
+        UnloadRenderTexture(bloom->levels[i][0]);
+        UnloadRenderTexture(bloom->levels[i][1]);
+    }
+    bloom->level_count = 0;
+}
+
+void Bloom_begin(const Bloom* bloom, Color background)
+{
+    if (bloom->level_count == 0) {
+        return;
+    }
+    BeginTextureMode(bloom->scene);
+    ClearBackground(background);
+    BeginMode2D((Camera2D) { .offset = { -bloom->area.x * bloom->zoom, -bloom->area.y * bloom->zoom }, .zoom = bloom->zoom });
+}
+
+void Bloom_end(const Bloom* bloom)
+{
+    if (bloom->level_count == 0) {
+        return;
+    }
+    EndMode2D();
+    EndTextureMode();
+
+    // Bright pass, downsampled to the first level
+    Bloom_pass(bloom->scene, bloom->levels[0][0], bloom->bright);
+
+    for (int i = 0; i < bloom->level_count; ++i) {
+        RenderTexture2D blurred = bloom->levels[i][0];
+        RenderTexture2D half_way = bloom->levels[i][1];
+
+        // One pixel of this level along the axis of the pass. Every pass ends drawing its
+        // batch, so a uniform set between two passes is seen by the next one only
+        float horizontal[2] = { 1.0f / (float)blurred.texture.width, 0.0f };
+        float vertical[2] = { 0.0f, 1.0f / (float)blurred.texture.height };
+        SetShaderValue(bloom->blur, bloom->direction_loc, horizontal, SHADER_UNIFORM_VEC2);
+        Bloom_pass(blurred, half_way, bloom->blur);
+        SetShaderValue(bloom->blur, bloom->direction_loc, vertical, SHADER_UNIFORM_VEC2);
+        Bloom_pass(half_way, blurred, bloom->blur);
+
+        if (i + 1 < bloom->level_count) {
+            Bloom_pass(blurred, bloom->levels[i + 1][0], (Shader) { 0 });
+        }
+    }
+}
+
+void Bloom_draw(const Bloom* bloom)
+{
+    if (bloom->level_count == 0) {
+        return;
+    }
+    Texture2D scene = bloom->scene.texture;
+    DrawTexturePro(scene, (Rectangle) { 0.0f, 0.0f, (float)scene.width, -(float)scene.height }, bloom->area, (Vector2) { 0.0f, 0.0f }, 0.0f, WHITE);
+    BeginBlendMode(BLEND_ADDITIVE);
+    for (int i = 0; i < bloom->level_count; ++i) {
+        Texture2D level = bloom->levels[i][0].texture;
+        DrawTexturePro(
+            level,
+            (Rectangle) { 0.0f, 0.0f, (float)level.width, -(float)level.height },
+            bloom->area,
+            (Vector2) { 0.0f, 0.0f },
+            0.0f,
+            Fade(WHITE, BLOOM_INTENSITY / (float)bloom->level_count));
+    }
+    EndBlendMode();
+}
+
+void Bloom_pass(RenderTexture2D from, RenderTexture2D to, Shader shader)
+{
+    BeginTextureMode(to);
+    ClearBackground(BLANK);
+    if (shader.id != 0) {
+        BeginShaderMode(shader);
+    }
+    DrawTexturePro(
+        from.texture,
+        (Rectangle) { 0.0f, 0.0f, (float)from.texture.width, -(float)from.texture.height },
+        (Rectangle) { 0.0f, 0.0f, (float)to.texture.width, (float)to.texture.height },
+        (Vector2) { 0.0f, 0.0f },
+        0.0f,
+        WHITE);
+    if (shader.id != 0) {
+        EndShaderMode();
+    }
+    EndTextureMode();
+}
+
+RenderTexture2D Bloom_target(int width, int height)
+{
+    RenderTexture2D target = LoadRenderTexture(width, height);
+    SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(target.texture, TEXTURE_WRAP_CLAMP);
+    return target;
+}
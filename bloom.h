@@ -0,0 +1,57 @@
+#ifndef BLOOM_H_
+#define BLOOM_H_
+
+#include <raylib.h>
+
+/*
+    Bloom of the boards as a post process: they are drawn in an offscreen target as large as
+    their area of the layout at the internal resolution (see screen.h), then
+    - bright pass: only the colors over a threshold, at half resolution
+    - blur: every level is blurred horizontally and vertically (separable, 9 taps in 5
+      bilinear fetches) and downsampled to half into the next one
+    - composite: the area, then every level stretched over it with additive blending
+
+    The blur runs at half, quarter, ... resolution: every level costs a quarter of the one
+    before and blurs twice as wide. With 0 levels there are no render textures and the boards
+    are drawn with the rest of the layout.
+*/
+
+#define BLOOM_LEVELS_MAX 6
+#define BLOOM_DEFAULT_LEVELS 3
+#define BLOOM_THRESHOLD 0.6f // brightness (max of r, g, b) where the bloom starts
+#define BLOOM_INTENSITY 0.9f // of all the levels together
+
+typedef struct {
+    int level_count;
+    Rectangle area; // of the layout
+    float zoom; // internal resolution / layout
+    RenderTexture2D scene;
+    RenderTexture2D levels[BLOOM_LEVELS_MAX][2]; // blurred, and the half way of the blur
+
+    Shader bright;
+    Shader blur;
+    int threshold_loc;
+    int direction_loc;
+} Bloom;
+
+/*
+    Targets for the area of the layout drawn at zoom. level_count is clamped to [0, BLOOM_LEVELS_MAX] and to
+    the levels of at least 1 pixel
+*/
+void Bloom_init(Bloom* bloom, Rectangle area, float zoom, int level_count);
+void Bloom_free(Bloom* bloom);
+
+/*
+    Everything drawn between Bloom_begin and Bloom_end blooms, in the coordinates of the
+    layout. The area starts from background and what falls out of it is lost. They use
+    their own render textures, so they go before Screen_begin
+*/
+void Bloom_begin(const Bloom* bloom, Color background);
+void Bloom_end(const Bloom* bloom);
+
+/*
+    Composite the area and its bloom, in the coordinates of the layout
+*/
+void Bloom_draw(const Bloom* bloom);
+
+#endif // BLOOM_H_
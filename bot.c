@@ -0,0 +1,354 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bot.h"
+
+// Seconds per row of the falling bot piece: it soft drops like a player holding down
+#define BOT_DROP_DELAY (1.0f / 30.0f)
+
+/*
+    Write a formatted line to the bot, mark it dead if the pipe is closed or full: a bot
+    that leaves a whole pipe of requests unread is stuck, and the game must not wait for it
+*/
+void Bot_write(Bot* bot, const char* format, ...);
+
+/*
+    Return true if line is a move
+*/
+bool Bot_parse_line(Bot* bot, const char* line, BotMove* move);
+
+/*
+    Apply move to the piece next_id of game and start its fall on display, then pipeline
+    the next request
+*/
+void BotOpponent_drop(BotOpponent* opponent, BotMove move);
+
+int Piece_top_square(const Piece* piece);
+
+bool Bot_spawn(Bot* bot, const char* command)
+{
+    *bot = (Bot) { .pid = -1, .to_bot = -1, .from_bot = -1, .name = "bot" };
+#ifdef __EMSCRIPTEN__
+    (void)command;
+    return false;
+#else
+    int to_bot[2];
+    int from_bot[2];
+    if (pipe(to_bot) != 0) {
+        return false;
+    }
+    if (pipe(from_bot) != 0) {
+        close(to_bot[0]);
+        close(to_bot[1]);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(to_bot[0]);
+        close(to_bot[1]);
+        close(from_bot[0]);
+        close(from_bot[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(to_bot[0], STDIN_FILENO);
+        dup2(from_bot[1], STDOUT_FILENO);
+        close(to_bot[0]);
+        close(to_bot[1]);
+        close(from_bot[0]);
+        close(from_bot[1]);
+        execl("/bin/sh", "sh", "-c", command, (char*)nullptr);
+        _exit(127);
+    }
+
+    close(to_bot[0]);
+    close(from_bot[1]);
+    fcntl(from_bot[0], F_SETFL, fcntl(from_bot[0], F_GETFL) | O_NONBLOCK);
+    fcntl(to_bot[1], F_SETFL, fcntl(to_bot[1], F_GETFL) | O_NONBLOCK);
+    // A bot that exits must not kill the game on the next write
+    signal(SIGPIPE, SIG_IGN);
+
+    bot->pid = pid;
+    bot->to_bot = to_bot[1];
+    bot->from_bot = from_bot[0];
+    bot->alive = true;
+    return true;
+#endif
+}
+
+void Bot_free(Bot* bot)
+{
+    if (bot->pid <= 0) {
+        return;
+    }
+    Bot_write(bot, "quit\n");
+    close(bot->to_bot);
+    close(bot->from_bot);
+
+    if (waitpid(bot->pid, nullptr, WNOHANG) == 0) {
+        kill(bot->pid, SIGTERM);
+        waitpid(bot->pid, nullptr, 0);
+    }
+    bot->pid = -1;
+    bot->alive = false;
+}
+
+void Bot_write(Bot* bot, const char* format, ...)
+{
+    if (!bot->alive) {
+        return;
+    }
+
+    char buffer[BOT_LINE_MAX];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0 || length >= (int)sizeof(buffer)) {
+        return;
+    }
+
+    for (int written = 0; written < length;) {
+        ssize_t n = write(bot->to_bot, buffer + written, (size_t)(length - written));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        // EAGAIN too: the frame loop never blocks on the bot
+        if (n <= 0) {
+            bot->alive = false;
+            return;
+        }
+        written += (int)n;
+    }
+}
+
+void Bot_send_start(Bot* bot, uint32_t id, const Game* game)
+{
+    char board[BOT_BOARD_CHARS + 1];
+    Board_to_string(&game->board, board);
+    char preview[PREVIEW_MAX + 1] = { 0 };
+    for (int i = 0; i < game->preview_length; ++i) {
+        preview[i] = PieceKind_to_char(Game_next_kind(game, i));
+    }
+    Bot_write(bot, "start %u %c %s %s\n", id, PieceKind_to_char(game->active_piece.kind), preview, board);
+}
+
+void Bot_send_suggest(Bot* bot, uint32_t id)
+{
+    Bot_write(bot, "suggest %u\n", id);
+}
+
+void Bot_send_play(Bot* bot, uint32_t id, int rotation, int column)
+{
+    Bot_write(bot, "play %u %d %d\n", id, rotation, column);
+}
+
+void Bot_send_new_piece(Bot* bot, PieceKind kind)
+{
+    Bot_write(bot, "new_piece %c\n", PieceKind_to_char(kind));
+}
+
+bool Bot_poll(Bot* bot, BotMove* move)
+{
+    while (bot->alive) {
+        char* newline = memchr(bot->line, '\n', (size_t)bot->line_length);
+        if (newline == nullptr) {
+            // A line longer than the buffer is not part of the protocol, drop it
+            if (bot->line_length == BOT_LINE_MAX) {
+                bot->line_length = 0;
+            }
+            ssize_t n = read(bot->from_bot, bot->line + bot->line_length, (size_t)(BOT_LINE_MAX - bot->line_length));
+            if (n > 0) {
+                bot->line_length += (int)n;
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                bot->alive = false;
+            }
+            return false;
+        }
+
+        *newline = '\0';
+        bool is_move = Bot_parse_line(bot, bot->line, move);
+        int consumed = (int)(newline - bot->line) + 1;
+        memmove(bot->line, newline + 1, (size_t)(bot->line_length - consumed));
+        bot->line_length -= consumed;
+
+        if (is_move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Bot_parse_line(Bot* bot, const char* line, BotMove* move)
+{
+    if (sscanf(line, "move %u %d %d", &move->id, &move->rotation, &move->column) == 3) {
+        return true;
+    }
+
+    char name[BOT_NAME_MAX];
+    if (sscanf(line, "ready %31s", name) == 1) {
+        memcpy(bot->name, name, sizeof(name));
+    }
+    return false;
+}
+
+char PieceKind_to_char(PieceKind kind)
+{
+    return kind < Empty ? "TJZOSLI"[kind] : '.';
+}
+
+PieceKind PieceKind_from_char(char c)
+{
+    const char* kinds = "TJZOSLI";
+    const char* found = c != '\0' ? strchr(kinds, c) : nullptr;
+    return found != nullptr ? (PieceKind)(found - kinds) : Empty;
+}
+
+void Board_to_string(const Board* board, char out[BOT_BOARD_CHARS + 1])
+{
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            out[row * COLS + col] = (*board)[row][col].active ? 'x' : '.';
+        }
+    }
+    out[BOT_BOARD_CHARS] = '\0';
+}
+
+bool Board_from_string(Board* board, const char* string, PieceKind kind)
+{
+    if (strlen(string) < BOT_BOARD_CHARS) {
+        return false;
+    }
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            bool active = string[row * COLS + col] != '.';
+            (*board)[row][col] = (Slot) { .active = active, .type = active ? kind : Empty };
+        }
+    }
+    return true;
+}
+
+bool BotOpponent_init(BotOpponent* opponent, const char* command)
+{
+    *opponent = (BotOpponent) { 0 };
+    return Bot_spawn(&opponent->bot, command);
+}
+
+void BotOpponent_free(BotOpponent* opponent)
+{
+    Bot_free(&opponent->bot);
+}
+
+void BotOpponent_start(BotOpponent* opponent, const Game* game, int start_level)
+{
+    int best_score = opponent->display.score > opponent->display.best_score ? opponent->display.score : opponent->display.best_score;
+
+    opponent->game = *game;
+    opponent->game.best_score = best_score;
+    opponent->display = opponent->game;
+    opponent->falling = false;
+    opponent->has_pending = false;
+    opponent->game_over = false;
+    opponent->start_level = start_level;
+    opponent->row_timer = 0.0f;
+
+    // Skip an id, so a late answer to the last request of the previous game is ignored
+    opponent->next_id += 1;
+    Bot_send_start(&opponent->bot, opponent->next_id, &opponent->game);
+    Bot_send_suggest(&opponent->bot, opponent->next_id);
+}
+
+void BotOpponent_update(BotOpponent* opponent, float delta_time, float row_delay)
+{
+    BotMove move;
+    while (Bot_poll(&opponent->bot, &move)) {
+        if (move.id == opponent->next_id && !opponent->has_pending) {
+            opponent->pending = move;
+            opponent->has_pending = true;
+        }
+    }
+
+    if (!opponent->falling && opponent->has_pending && !opponent->game_over) {
+        opponent->has_pending = false;
+        BotOpponent_drop(opponent, opponent->pending);
+    }
+
+    if (!opponent->falling) {
+        return;
+    }
+
+    float delay = row_delay < BOT_DROP_DELAY ? row_delay : BOT_DROP_DELAY;
+    opponent->row_timer += delta_time;
+    while (opponent->falling && opponent->row_timer >= delay) {
+        opponent->row_timer -= delay;
+
+        Piece* piece = &opponent->display.active_piece;
+        if (Piece_top_square(piece) >= Piece_top_square(&opponent->target)) {
+            // Landed: game already has the piece locked and the next one spawned
+            opponent->display = opponent->game;
+            opponent->falling = false;
+            opponent->game_over = Game_check_game_over(&opponent->display);
+        } else {
+            for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+                piece->squares[i][0] += 1;
+            }
+        }
+    }
+}
+
+void BotOpponent_drop(BotOpponent* opponent, BotMove move)
+{
+    Game before = opponent->game;
+    uint32_t id = opponent->next_id;
+
+    if (!Game_place_active_piece(&opponent->game, move.rotation, move.column)) {
+        // Illegal move: the piece drops where it spawned
+        opponent->game = before;
+        move.rotation = 0;
+        move.column = Piece_left_square(&opponent->game.active_piece);
+        Game_place_active_piece(&opponent->game, move.rotation, move.column);
+    }
+    opponent->target = opponent->game.active_piece;
+    Game_lock_active_piece(&opponent->game, opponent->start_level, nullptr);
+    opponent->next_id = id + 1;
+
+    // Pipelining: the bot knows the next piece before this one lands
+    Bot_send_play(&opponent->bot, id, move.rotation, move.column);
+    Bot_send_new_piece(&opponent->bot, Game_next_kind(&opponent->game, opponent->game.preview_length - 1));
+    if (!Game_check_game_over(&opponent->game)) {
+        Bot_send_suggest(&opponent->bot, opponent->next_id);
+    }
+
+    // On screen the piece starts from the spawn rows, already rotated and moved
+    Piece falling = opponent->target;
+    int rows_up = Piece_top_square(&falling) - Piece_top_square(&before.active_piece);
+    for (int i = 0; i < ARRAY_LEN_INT(falling.squares); ++i) {
+        falling.squares[i][0] -= rows_up;
+    }
+    opponent->display = before;
+    opponent->display.active_piece = falling;
+    opponent->falling = true;
+    opponent->row_timer = 0.0f;
+}
+
+int Piece_top_square(const Piece* piece)
+{
+    int top = piece->squares[0][0];
+    for (int i = 1; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        if (piece->squares[i][0] < top) {
+            top = piece->squares[i][0];
+        }
+    }
+    return top;
+}
@@ -0,0 +1,117 @@
+#ifndef BOT_H_
+#define BOT_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "game.h"
+
+/*
+    Text protocol between the game and an external bot process on its stdin/stdout, one
+    message per line with the fields separated by spaces (modelled on the Tetris Bot
+    Protocol):
+
+    bot  -> game   ready <name>                    optional, the name shown on screen
+    game -> bot    start <id> <active> <preview> <board>
+                   a new game where piece id is active. Kinds are letters (TJZOSLI), the
+                   preview is the upcoming kinds (1 to PREVIEW_MAX letters), the board is
+                   TOTAL_ROWS * COLS characters, row major from the top row, '.' empty and
+                   'x' occupied
+    game -> bot    suggest <id>                    ask where to put piece id
+    bot  -> game   move <id> <rotation> <column>   clockwise rotations from the spawn
+                                                   position, column of the most left square
+    game -> bot    play <id> <rotation> <column>   piece id was locked there
+    game -> bot    new_piece <kind>                the kind that entered the end of the preview
+                                                   with the last play
+    game -> bot    quit
+
+    Requests are pipelined: when piece id starts falling on screen its play, new_piece and
+    suggest id + 1 are already sent, so the bot thinks about the next piece while the
+    previous one is falling. Unknown lines are ignored on both sides.
+*/
+
+#define BOT_LINE_MAX 512
+#define BOT_NAME_MAX 32
+#define BOT_BOARD_CHARS (TOTAL_ROWS * COLS)
+
+typedef struct {
+    pid_t pid;
+    int to_bot;
+    int from_bot;
+    char line[BOT_LINE_MAX];
+    int line_length;
+    char name[BOT_NAME_MAX];
+    bool alive;
+} Bot;
+
+typedef struct {
+    uint32_t id;
+    int rotation;
+    int column;
+} BotMove;
+
+/*
+    An opponent board played by a bot: game runs ahead (a move is applied as soon as its
+    piece starts falling), display is what is on screen
+*/
+typedef struct {
+    Bot bot;
+    Game game;
+    Game display;
+    Piece target; // where the falling piece of display lands
+    uint32_t next_id; // id of the active piece of game
+    BotMove pending; // move arrived while the previous piece was falling
+    bool has_pending;
+    bool falling;
+    bool game_over;
+    int start_level;
+    float row_timer;
+} BotOpponent;
+
+/*
+    Run command with /bin/sh, connected through pipes. Return false if it cannot start
+    (always on the web)
+*/
+bool Bot_spawn(Bot* bot, const char* command);
+void Bot_free(Bot* bot);
+
+void Bot_send_start(Bot* bot, uint32_t id, const Game* game);
+void Bot_send_suggest(Bot* bot, uint32_t id);
+void Bot_send_play(Bot* bot, uint32_t id, int rotation, int column);
+void Bot_send_new_piece(Bot* bot, PieceKind kind);
+
+/*
+    Read what the bot wrote, without blocking. Return true and fill move for every move
+    line (call it until it returns false)
+*/
+bool Bot_poll(Bot* bot, BotMove* move);
+
+char PieceKind_to_char(PieceKind kind);
+
+/*
+    Empty if c is not a piece letter
+*/
+PieceKind PieceKind_from_char(char c);
+
+void Board_to_string(const Board* board, char out[BOT_BOARD_CHARS + 1]);
+
+/*
+    Occupied squares get type kind. Return false if the string is not a board
+*/
+bool Board_from_string(Board* board, const char* string, PieceKind kind);
+
+bool BotOpponent_init(BotOpponent* opponent, const char* command);
+void BotOpponent_free(BotOpponent* opponent);
+
+/*
+    Start a new game for the bot, a copy of game (so it gets the same pieces)
+*/
+void BotOpponent_start(BotOpponent* opponent, const Game* game, int start_level);
+
+/*
+    Take the moves of the bot and advance the falling piece by delta_time, one row every
+    row_delay seconds
+*/
+void BotOpponent_update(BotOpponent* opponent, float delta_time, float row_delay);
+
+#endif // BOT_H_
@@ -0,0 +1,184 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "cetris_env.h"
+
+static_assert(CETRIS_ENV_ROWS == TOTAL_ROWS && CETRIS_ENV_COLS == COLS, "The API board must match the game board");
+static_assert(CETRIS_ENV_ACTIONS == ActionCount && CETRIS_ENV_ACTION_HARD_DROP == HardDrop, "The API actions must match Action");
+static_assert(CETRIS_ENV_RANDOMIZER_NES == Nes, "The API randomizers must match Randomizer");
+
+struct CetrisEnv {
+    GameBatch batch;
+    int start_level;
+    bool auto_reset;
+    Rng seeder; // seeds of the new games
+    int32_t* previous_score;
+};
+
+/*
+    New game in slot game, seeded by the env seeder
+*/
+void CetrisEnv_reset_one(CetrisEnv* env, int game);
+
+/*
+    True if 0 <= first <= last <= num_envs. The ranges come from the bindings, the asserts
+    of the batch are gone in the optimized builds
+*/
+bool CetrisEnv_valid_range(const CetrisEnv* env, int32_t first, int32_t last);
+
+int32_t cetris_env_api_version(void)
+{
+    return CETRIS_ENV_API_VERSION;
+}
+
+CetrisEnv* cetris_env_create(const CetrisEnvConfig* config)
+{
+    if (config == nullptr || config->num_envs <= 0 || config->start_level < 0 || config->start_level > 9
+        || config->randomizer < CETRIS_ENV_RANDOMIZER_UNIFORM || config->randomizer > CETRIS_ENV_RANDOMIZER_NES) {
+        return nullptr;
+    }
+
+    CetrisEnv* env = calloc(1, sizeof(CetrisEnv));
+    if (env == nullptr) {
+        return nullptr;
+    }
+    env->start_level = config->start_level;
+    env->auto_reset = config->auto_reset != 0;
+    env->seeder = Rng_seed(config->seed);
+    env->previous_score = calloc((size_t)config->num_envs, sizeof(int32_t));
+
+    if (env->previous_score == nullptr || !GameBatch_init(&env->batch, config->num_envs, (Randomizer)config->randomizer)) {
+        free(env->previous_score);
+        free(env);
+        return nullptr;
+    }
+
+    cetris_env_reset(env, nullptr);
+    return env;
+}
+
+void cetris_env_destroy(CetrisEnv* env)
+{
+    if (env == nullptr) {
+        return;
+    }
+    GameBatch_free(&env->batch);
+    free(env->previous_score);
+    free(env);
+}
+
+int32_t cetris_env_num_envs(const CetrisEnv* env)
+{
+    return env->batch.count;
+}
+
+void CetrisEnv_reset_one(CetrisEnv* env, int game)
+{
+    GameBatch_reset(&env->batch, game, env->start_level, Rng_next(&env->seeder));
+    env->previous_score[game] = 0;
+}
+
+void cetris_env_reset(CetrisEnv* env, const uint8_t* mask)
+{
+    cetris_env_reset_range(env, 0, env->batch.count, mask);
+}
+
+void cetris_env_step(CetrisEnv* env, const uint8_t* actions, float* rewards, uint8_t* dones)
+{
+    cetris_env_step_range(env, 0, env->batch.count, actions, rewards, dones);
+}
+
+void cetris_env_observe(const CetrisEnv* env, const CetrisObservation* observation)
+{
+    cetris_env_observe_range(env, 0, env->batch.count, observation);
+}
+
+bool CetrisEnv_valid_range(const CetrisEnv* env, int32_t first, int32_t last)
+{
+    return 0 <= first && first <= last && last <= env->batch.count;
+}
+
+void cetris_env_reset_range(CetrisEnv* env, int32_t first, int32_t last, const uint8_t* mask)
+{
+    if (!CetrisEnv_valid_range(env, first, last)) {
+        return;
+    }
+    for (int game = first; game < last; ++game) {
+        if (mask == nullptr || mask[game - first] != 0) {
+            CetrisEnv_reset_one(env, game);
+        }
+    }
+}
+
+void cetris_env_step_range(CetrisEnv* env, int32_t first, int32_t last, const uint8_t* actions, float* rewards, uint8_t* dones)
+{
+    if (!CetrisEnv_valid_range(env, first, last)) {
+        return;
+    }
+    GameBatch* batch = &env->batch;
+    GameBatch_step_range(batch, actions, first, last);
+
+    for (int game = first; game < last; ++game) {
+        if (rewards != nullptr) {
+            rewards[game - first] = (float)(batch->score[game] - env->previous_score[game]);
+        }
+        env->previous_score[game] = batch->score[game];
+
+        uint8_t done = batch->done[game];
+        if (dones != nullptr) {
+            dones[game - first] = done;
+        }
+        if (done && env->auto_reset) {
+            CetrisEnv_reset_one(env, game);
+        }
+    }
+}
+
+void cetris_env_observe_range(const CetrisEnv* env, int32_t first, int32_t last, const CetrisObservation* observation)
+{
+    if (!CetrisEnv_valid_range(env, first, last)) {
+        return;
+    }
+    const GameBatch* batch = &env->batch;
+    const size_t plane_size = CETRIS_ENV_ROWS * CETRIS_ENV_COLS;
+
+    for (int game = first; game < last; ++game) {
+        const size_t index = (size_t)(game - first);
+
+        if (observation->board != nullptr) {
+            uint8_t* locked = observation->board + index * CETRIS_ENV_PLANES * plane_size;
+            uint8_t* active = locked + plane_size;
+
+            for (int row = 0; row < TOTAL_ROWS; ++row) {
+                uint16_t bits = batch->rows[(row + BATCH_PAD) * batch->count + game] >> BATCH_WALL;
+                for (int col = 0; col < COLS; ++col) {
+                    locked[row * COLS + col] = (uint8_t)((bits >> col) & 1);
+                }
+            }
+
+            memset(active, 0, plane_size);
+            Square squares[4];
+            GameBatch_active_squares(batch, game, squares);
+            for (int i = 0; i < 4; ++i) {
+                active[squares[i][0] * COLS + squares[i][1]] = 1;
+            }
+        }
+
+        if (observation->pieces != nullptr) {
+            observation->pieces[index * CETRIS_ENV_PIECES + 0] = (int8_t)batch->kind[game];
+            observation->pieces[index * CETRIS_ENV_PIECES + 1] = (int8_t)batch->next_kind[game];
+        }
+
+        if (observation->scalars != nullptr) {
+            float* scalars = observation->scalars + index * CETRIS_ENV_SCALARS;
+            scalars[CETRIS_ENV_SCALAR_SCORE] = (float)batch->score[game];
+            scalars[CETRIS_ENV_SCALAR_LINES] = (float)batch->lines[game];
+            scalars[CETRIS_ENV_SCALAR_LEVEL] = (float)batch->level[game];
+            scalars[CETRIS_ENV_SCALAR_PIECE_ROW] = (float)batch->piece_row[game];
+            scalars[CETRIS_ENV_SCALAR_PIECE_COL] = (float)batch->piece_col[game];
+            scalars[CETRIS_ENV_SCALAR_ROTATION] = (float)batch->rotation[game];
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef CETRIS_ENV_H_
+#define CETRIS_ENV_H_
+
+#include <stdint.h>
+
+/*
+    Stable C API to run a vector of Cetris environments (for RL training).
+    Observations are written straight into buffers owned by the caller, so bindings
+    (ctypes + NumPy, ...) can hand their arrays to it without any copy, and nothing is
+    allocated after cetris_env_create.
+
+    This header does not depend on the rest of the game: only fixed width types and the
+    constants below, which never change within the same CETRIS_ENV_API_VERSION.
+*/
+
+#define CETRIS_ENV_API_VERSION 1
+
+/*
+    Board planes: [num_envs][CETRIS_ENV_PLANES][CETRIS_ENV_ROWS][CETRIS_ENV_COLS] of uint8_t,
+    plane 0 the locked squares, plane 1 the active piece (1 occupied, 0 empty).
+    The rows include the 2 hidden rows on top
+*/
+#define CETRIS_ENV_ROWS 22
+#define CETRIS_ENV_COLS 10
+#define CETRIS_ENV_PLANES 2
+
+/*
+    Piece ids: [num_envs][CETRIS_ENV_PIECES] of int8_t, the active kind then the next kind
+    (0 T, 1 J, 2 Z, 3 O, 4 S, 5 L, 6 I)
+*/
+#define CETRIS_ENV_PIECES 2
+
+/*
+    Scalar features: [num_envs][CETRIS_ENV_SCALARS] of float, in this order. Piece row/col
+    are the board coordinates of the square the active piece rotates around, rotation is
+    the number of clockwise rotations from the spawn position (0-3)
+*/
+#define CETRIS_ENV_SCALARS 6
+#define CETRIS_ENV_SCALAR_SCORE 0
+#define CETRIS_ENV_SCALAR_LINES 1
+#define CETRIS_ENV_SCALAR_LEVEL 2
+#define CETRIS_ENV_SCALAR_PIECE_ROW 3
+#define CETRIS_ENV_SCALAR_PIECE_COL 4
+#define CETRIS_ENV_SCALAR_ROTATION 5
+
+/*
+    Actions: one uint8_t per environment, applied before the gravity of the step
+*/
+#define CETRIS_ENV_ACTION_NONE 0
+#define CETRIS_ENV_ACTION_LEFT 1
+#define CETRIS_ENV_ACTION_RIGHT 2
+#define CETRIS_ENV_ACTION_ROTATE_LEFT 3
+#define CETRIS_ENV_ACTION_ROTATE_RIGHT 4
+#define CETRIS_ENV_ACTION_SOFT_DROP 5
+#define CETRIS_ENV_ACTION_HARD_DROP 6
+#define CETRIS_ENV_ACTIONS 7
+
+#define CETRIS_ENV_RANDOMIZER_UNIFORM 0
+#define CETRIS_ENV_RANDOMIZER_BAG 1
+#define CETRIS_ENV_RANDOMIZER_NES 2
+
+typedef struct CetrisEnv CetrisEnv;
+
+typedef struct {
+    int32_t num_envs;
+    int32_t start_level; // 0-9
+    int32_t randomizer; // CETRIS_ENV_RANDOMIZER_*
+    int32_t auto_reset; // if not 0 an environment that ends is reset inside the same step
+    uint64_t seed;
+} CetrisEnvConfig;
+
+/*
+    Caller owned output buffers, any of them can be NULL to skip it
+*/
+typedef struct {
+    uint8_t* board; // [num_envs][CETRIS_ENV_PLANES][CETRIS_ENV_ROWS][CETRIS_ENV_COLS]
+    int8_t* pieces; // [num_envs][CETRIS_ENV_PIECES]
+    float* scalars; // [num_envs][CETRIS_ENV_SCALARS]
+} CetrisObservation;
+
+int32_t cetris_env_api_version(void);
+
+/*
+    Return NULL if the config is invalid or the allocation fails. Every environment starts
+    already reset
+*/
+CetrisEnv* cetris_env_create(const CetrisEnvConfig* config);
+void cetris_env_destroy(CetrisEnv* env);
+
+int32_t cetris_env_num_envs(const CetrisEnv* env);
+
+/*
+    Start a new game in every environment with mask[i] != 0 (all of them if mask is NULL)
+*/
+void cetris_env_reset(CetrisEnv* env, const uint8_t* mask);
+
+/*
+    Step every environment with actions[num_envs]. rewards[num_envs] (the score gained)
+    and dones[num_envs] can be NULL. A done environment stays still until it is reset,
+    unless auto_reset is set
+*/
+void cetris_env_step(CetrisEnv* env, const uint8_t* actions, float* rewards, uint8_t* dones);
+
+/*
+    Write the current observation of every environment into the caller buffers
+*/
+void cetris_env_observe(const CetrisEnv* env, const CetrisObservation* observation);
+
+/*
+    Same as reset, step and observe but only for the environments in [first, last): every
+    buffer holds last - first entries and starts with the ones of environment first.
+    They do nothing (and leave the buffers untouched) unless 0 <= first <= last <= num_envs
+*/
+void cetris_env_reset_range(CetrisEnv* env, int32_t first, int32_t last, const uint8_t* mask);
+void cetris_env_step_range(CetrisEnv* env, int32_t first, int32_t last, const uint8_t* actions, float* rewards, uint8_t* dones);
+void cetris_env_observe_range(const CetrisEnv* env, int32_t first, int32_t last, const CetrisObservation* observation);
+
+#endif // CETRIS_ENV_H_
@@ -0,0 +1,221 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cetris_envd.h"
+
+// Polls of the response before sleeping on the futex, a step usually takes a few microseconds
+#define CLIENT_SPINS 4096
+#define SEGMENT_ALIGN 64
+
+struct CetrisEnvdClient {
+    CetrisEnvdHeader* header;
+    size_t size;
+    CetrisEnvdSlot* slot;
+    CetrisEnvdBuffers buffers;
+};
+
+/*
+    Send command to the server and wait for its response
+*/
+bool CetrisEnvdClient_request(CetrisEnvdClient* client, uint32_t command);
+
+/*
+    False if the server exited without clearing running (killed)
+*/
+bool CetrisEnvdClient_server_alive(const CetrisEnvdClient* client);
+
+uint64_t align_offset(uint64_t offset);
+
+CetrisEnvdClient* cetris_envd_connect(const char* name)
+{
+    int fd = shm_open(name != nullptr ? name : CETRIS_ENVD_DEFAULT_NAME, O_RDWR, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(CetrisEnvdHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+
+    CetrisEnvdHeader* header = memory;
+    if (header->magic != CETRIS_ENVD_MAGIC || header->version != CETRIS_ENVD_VERSION
+        || header->api_version != CETRIS_ENV_API_VERSION || header->size != (uint64_t)info.st_size
+        || atomic_load(&header->running) == 0) {
+        munmap(memory, (size_t)info.st_size);
+        return nullptr;
+    }
+
+    CetrisEnvdClient* client = calloc(1, sizeof(CetrisEnvdClient));
+    if (client == nullptr) {
+        munmap(memory, (size_t)info.st_size);
+        return nullptr;
+    }
+    client->header = header;
+    client->size = (size_t)info.st_size;
+
+    CetrisEnvdSlot* slots = (CetrisEnvdSlot*)((uint8_t*)memory + header->slots_offset);
+    int index = 0;
+    for (; index < header->num_clients; ++index) {
+        uint32_t expected = CETRIS_ENVD_SLOT_FREE;
+        if (atomic_compare_exchange_strong(&slots[index].state, &expected, CETRIS_ENVD_SLOT_ATTACHED)) {
+            break;
+        }
+    }
+    if (index == header->num_clients) {
+        cetris_envd_disconnect(client);
+        return nullptr;
+    }
+    client->slot = &slots[index];
+    client->slot->pid = (int32_t)getpid();
+
+    uint8_t* base = memory;
+    size_t first = (size_t)index * (size_t)header->envs_per_client;
+    const size_t board_size = CETRIS_ENV_PLANES * CETRIS_ENV_ROWS * CETRIS_ENV_COLS;
+    client->buffers = (CetrisEnvdBuffers) {
+        .num_envs = header->envs_per_client,
+        .actions = base + header->actions_offset + first,
+        .reset_mask = base + header->reset_mask_offset + first,
+        .rewards = (const float*)(base + header->rewards_offset) + first,
+        .dones = base + header->dones_offset + first,
+        .observation = {
+            .board = base + header->board_offset + first * board_size,
+            .pieces = (int8_t*)(base + header->pieces_offset) + first * CETRIS_ENV_PIECES,
+            .scalars = (float*)(base + header->scalars_offset) + first * CETRIS_ENV_SCALARS,
+        },
+    };
+
+    memset(client->buffers.reset_mask, 1, (size_t)header->envs_per_client);
+    if (!cetris_envd_reset(client)) {
+        cetris_envd_disconnect(client);
+        return nullptr;
+    }
+    return client;
+}
+
+void cetris_envd_disconnect(CetrisEnvdClient* client)
+{
+    if (client == nullptr) {
+        return;
+    }
+    if (client->slot != nullptr) {
+        client->slot->pid = 0;
+        atomic_store(&client->slot->state, CETRIS_ENVD_SLOT_FREE);
+    }
+    munmap(client->header, client->size);
+    free(client);
+}
+
+const CetrisEnvdBuffers* cetris_envd_buffers(const CetrisEnvdClient* client)
+{
+    return &client->buffers;
+}
+
+bool cetris_envd_step(CetrisEnvdClient* client)
+{
+    return CetrisEnvdClient_request(client, CETRIS_ENVD_COMMAND_STEP);
+}
+
+bool cetris_envd_reset(CetrisEnvdClient* client)
+{
+    return CetrisEnvdClient_request(client, CETRIS_ENVD_COMMAND_RESET);
+}
+
+bool CetrisEnvdClient_request(CetrisEnvdClient* client, uint32_t command)
+{
+    CetrisEnvdHeader* header = client->header;
+    CetrisEnvdSlot* slot = client->slot;
+
+    slot->command = command;
+    // Release: the server sees the command and the actions once it sees the new request
+    uint32_t request = atomic_fetch_add_explicit(&slot->request, 1, memory_order_release) + 1;
+    atomic_fetch_add(&header->doorbell, 1);
+    if (atomic_load(&header->sleeping) != 0) {
+        cetris_envd_futex_wake(&header->doorbell, 1);
+    }
+
+    for (int spin = 0;; ++spin) {
+        uint32_t response = atomic_load_explicit(&slot->response, memory_order_acquire);
+        if (response == request) {
+            return true;
+        }
+        if (spin < CLIENT_SPINS) {
+            continue;
+        }
+        if (atomic_load(&header->running) == 0 || !CetrisEnvdClient_server_alive(client)) {
+            return false;
+        }
+        // Sequentially consistent with the server: it either sees waiting or we see the response
+        atomic_store(&slot->waiting, 1);
+        if (atomic_load(&slot->response) != request) {
+            cetris_envd_futex_wait(&slot->response, response, 100);
+        }
+        atomic_store(&slot->waiting, 0);
+    }
+}
+
+bool CetrisEnvdClient_server_alive(const CetrisEnvdClient* client)
+{
+    return kill(client->header->server_pid, 0) == 0 || errno != ESRCH;
+}
+
+uint64_t align_offset(uint64_t offset)
+{
+    return (offset + SEGMENT_ALIGN - 1) & ~(uint64_t)(SEGMENT_ALIGN - 1);
+}
+
+void cetris_envd_layout(CetrisEnvdHeader* header)
+{
+    uint64_t envs = (uint64_t)header->num_clients * (uint64_t)header->envs_per_client;
+    uint64_t offset = align_offset(sizeof(CetrisEnvdHeader));
+
+    header->slots_offset = offset;
+    offset = align_offset(offset + (uint64_t)header->num_clients * sizeof(CetrisEnvdSlot));
+    header->actions_offset = offset;
+    offset = align_offset(offset + envs);
+    header->reset_mask_offset = offset;
+    offset = align_offset(offset + envs);
+    header->rewards_offset = offset;
+    offset = align_offset(offset + envs * sizeof(float));
+    header->dones_offset = offset;
+    offset = align_offset(offset + envs);
+    header->board_offset = offset;
+    offset = align_offset(offset + envs * CETRIS_ENV_PLANES * CETRIS_ENV_ROWS * CETRIS_ENV_COLS);
+    header->pieces_offset = offset;
+    offset = align_offset(offset + envs * CETRIS_ENV_PIECES);
+    header->scalars_offset = offset;
+    offset = align_offset(offset + envs * CETRIS_ENV_SCALARS * sizeof(float));
+    header->size = offset;
+}
+
+void cetris_envd_futex_wait(_Atomic uint32_t* word, uint32_t value, int timeout_ms)
+{
+    struct timespec timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (long)(timeout_ms % 1000) * 1000000,
+    };
+    // Not FUTEX_PRIVATE: the word is shared between processes
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, value, timeout_ms < 0 ? nullptr : &timeout, nullptr, 0);
+}
+
+void cetris_envd_futex_wake(_Atomic uint32_t* word, int count)
+{
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
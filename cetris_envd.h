@@ -0,0 +1,116 @@
+#ifndef CETRIS_ENVD_H_
+#define CETRIS_ENVD_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cetris_env.h"
+
+/*
+    Shared memory protocol of cetris-envd (Linux only).
+
+    The daemon hosts num_clients * envs_per_client environments in one POSIX shared memory
+    segment. Every client owns a slot and the contiguous environments
+    [slot * envs_per_client, (slot + 1) * envs_per_client), so its actions, rewards, dones
+    and observations are contiguous slices of the arrays below, which the server steps and
+    observes in place (no copy on either side).
+
+    A request is: write the actions (or the reset mask), bump slot.request, bump the
+    header doorbell and wake the server on it. The server collects every pending request,
+    steps all of them together and publishes slot.response = slot.request, waking the
+    client on it. Both words are futexes, so nobody spins while idle, and the waker skips
+    the syscall when the other side is not sleeping (waiting/sleeping flags).
+
+    Every offset is in bytes from the start of the segment, so clients in other languages
+    can map it without this header.
+*/
+
+#define CETRIS_ENVD_MAGIC 0x44564e4553495254ull // "TRISENVD"
+#define CETRIS_ENVD_VERSION 1
+#define CETRIS_ENVD_DEFAULT_NAME "/cetris-envd"
+
+#define CETRIS_ENVD_SLOT_FREE 0
+#define CETRIS_ENVD_SLOT_ATTACHED 1
+
+#define CETRIS_ENVD_COMMAND_STEP 0
+#define CETRIS_ENVD_COMMAND_RESET 1
+
+/*
+    One per client, on its own cache line so the clients do not share lines
+*/
+typedef struct {
+    _Alignas(64) _Atomic uint32_t state; // CETRIS_ENVD_SLOT_*
+    _Atomic uint32_t request; // bumped by the client for every request
+    _Atomic uint32_t response; // set to request by the server when the request is done
+    _Atomic uint32_t waiting; // 1 while the client sleeps on response
+    uint32_t command; // CETRIS_ENVD_COMMAND_*, written before bumping request
+    int32_t pid; // of the client, to free the slot if it dies
+} CetrisEnvdSlot;
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version; // CETRIS_ENVD_VERSION
+    uint32_t api_version; // CETRIS_ENV_API_VERSION of the observations
+    int32_t num_clients;
+    int32_t envs_per_client;
+    int32_t server_pid;
+    _Atomic uint32_t running; // 0 when the server stops
+    _Alignas(64) _Atomic uint32_t doorbell; // bumped by the clients after every request
+    _Atomic uint32_t sleeping; // 1 while the server sleeps on doorbell
+
+    uint64_t size;
+    uint64_t slots_offset; // CetrisEnvdSlot[num_clients]
+    uint64_t actions_offset; // uint8_t[num_envs]
+    uint64_t reset_mask_offset; // uint8_t[num_envs]
+    uint64_t rewards_offset; // float[num_envs]
+    uint64_t dones_offset; // uint8_t[num_envs]
+    uint64_t board_offset; // uint8_t[num_envs][CETRIS_ENV_PLANES][CETRIS_ENV_ROWS][CETRIS_ENV_COLS]
+    uint64_t pieces_offset; // int8_t[num_envs][CETRIS_ENV_PIECES]
+    uint64_t scalars_offset; // float[num_envs][CETRIS_ENV_SCALARS]
+} CetrisEnvdHeader;
+
+/*
+    The slices of the shared arrays owned by a client
+*/
+typedef struct {
+    int32_t num_envs;
+    uint8_t* actions; // written by the client before cetris_envd_step
+    uint8_t* reset_mask; // written by the client before cetris_envd_reset
+    const float* rewards;
+    const uint8_t* dones;
+    CetrisObservation observation; // up to date after every step or reset
+} CetrisEnvdBuffers;
+
+typedef struct CetrisEnvdClient CetrisEnvdClient;
+
+/*
+    Attach to the server listening on name (CETRIS_ENVD_DEFAULT_NAME if NULL) and reset
+    every environment of the slot. Return NULL if there is no server, no free slot or the
+    versions do not match
+*/
+CetrisEnvdClient* cetris_envd_connect(const char* name);
+void cetris_envd_disconnect(CetrisEnvdClient* client);
+
+const CetrisEnvdBuffers* cetris_envd_buffers(const CetrisEnvdClient* client);
+
+/*
+    Step the environments of the client with its actions, or reset the ones with
+    reset_mask[i] != 0. Block until the server is done, return false if it stopped
+*/
+bool cetris_envd_step(CetrisEnvdClient* client);
+bool cetris_envd_reset(CetrisEnvdClient* client);
+
+/*
+    Fill the offsets and the size of header from num_clients and envs_per_client (server side)
+*/
+void cetris_envd_layout(CetrisEnvdHeader* header);
+
+/*
+    Futex helpers shared by the server and the clients. wait returns after a wake, a
+    timeout (in milliseconds, negative for none) or if *word != value
+*/
+void cetris_envd_futex_wait(_Atomic uint32_t* word, uint32_t value, int timeout_ms);
+void cetris_envd_futex_wake(_Atomic uint32_t* word, int count);
+
+#endif // CETRIS_ENVD_H_
@@ -0,0 +1,404 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "endless.h"
+
+/*
+    Empty every row of the board, keeping the chunks
+*/
+void EndlessBoard_clear(EndlessBoard* board);
+
+/*
+    Occupy the square with kind, row < the reserved rows
+*/
+void EndlessBoard_set(EndlessBoard* board, int row, int col, PieceKind kind);
+
+/*
+    True if none of the squares is occupied or out of the board
+*/
+bool EndlessGame_fits(const EndlessGame* game, const Square squares[4]);
+
+/*
+    Put a piece of kind ENDLESS_SPAWN_GAP rows over the stack. Return false if it does not fit
+*/
+bool EndlessGame_spawn_piece(EndlessGame* game, PieceKind kind);
+
+/*
+    Rules, garbage and first piece of a new game on the empty board
+*/
+bool EndlessGame_start(EndlessGame* game, int level, uint64_t seed, Randomizer randomizer);
+
+void EndlessBoard_init(EndlessBoard* board, int max_rows, int cols)
+{
+    assert(max_rows >= ENDLESS_ROWS_MIN && max_rows <= ENDLESS_ROWS_MAX && cols >= COLS_MIN && cols <= COLS_MAX);
+    *board = (EndlessBoard) { .cols = cols, .max_rows = max_rows };
+}
+
+void EndlessBoard_free(EndlessBoard* board)
+{
+    for (int i = 0; i < board->chunk_count; ++i) {
+        free(board->chunks[i]);
+    }
+    free(board->chunks);
+    free(board->rows);
+    *board = (EndlessBoard) { .cols = board->cols, .max_rows = board->max_rows };
+}
+
+void EndlessBoard_clear(EndlessBoard* board)
+{
+    for (int row = 0; row < board->height; ++row) {
+        Slot* slots = EndlessBoard_row(board, row);
+        for (int col = 0; col < board->cols; ++col) {
+            slots[col] = (Slot) { .active = false, .type = Empty };
+        }
+    }
+    board->height = 0;
+    memset(board->column_heights, 0, sizeof(board->column_heights));
+}
+
+bool EndlessBoard_reserve(EndlessBoard* board, int rows)
+{
+    if (rows > board->max_rows) {
+        return false;
+    }
+
+    while (board->chunk_count * ENDLESS_CHUNK_ROWS < rows) {
+        Slot* chunk = malloc(sizeof(Slot) * ENDLESS_CHUNK_ROWS * board->cols);
+        Slot** chunks = realloc(board->chunks, sizeof(Slot*) * (board->chunk_count + 1));
+        if (chunks != nullptr) {
+            board->chunks = chunks;
+        }
+        // Only the index grows with the board, the rows already in use stay where they are
+        uint32_t* indices = realloc(board->rows, sizeof(uint32_t) * (board->chunk_count + 1) * ENDLESS_CHUNK_ROWS);
+        if (indices != nullptr) {
+            board->rows = indices;
+        }
+        if (chunk == nullptr || chunks == nullptr || indices == nullptr) {
+            free(chunk);
+            return false;
+        }
+
+        for (int i = 0; i < ENDLESS_CHUNK_ROWS * board->cols; ++i) {
+            chunk[i] = (Slot) { .active = false, .type = Empty };
+        }
+        uint32_t first = (uint32_t)(board->chunk_count * ENDLESS_CHUNK_ROWS);
+        for (uint32_t i = 0; i < ENDLESS_CHUNK_ROWS; ++i) {
+            board->rows[first + i] = first + i;
+        }
+        board->chunks[board->chunk_count++] = chunk;
+    }
+
+    return true;
+}
+
+Slot* EndlessBoard_row(const EndlessBoard* board, int row)
+{
+    uint32_t index = board->rows[row];
+    return &board->chunks[index / ENDLESS_CHUNK_ROWS][(index % ENDLESS_CHUNK_ROWS) * board->cols];
+}
+
+bool EndlessBoard_occupied(const EndlessBoard* board, int row, int col)
+{
+    if (row < 0 || row >= board->max_rows || col < 0 || col >= board->cols) {
+        return true;
+    }
+    if (row >= board->height) {
+        return false;
+    }
+    return EndlessBoard_row(board, row)[col].active;
+}
+
+void EndlessBoard_set(EndlessBoard* board, int row, int col, PieceKind kind)
+{
+    EndlessBoard_row(board, row)[col] = (Slot) { .active = true, .type = kind };
+    if (row + 1 > board->column_heights[col]) {
+        board->column_heights[col] = row + 1;
+    }
+    if (row + 1 > board->height) {
+        board->height = row + 1;
+    }
+}
+
+int EndlessBoard_delete_full_rows(EndlessBoard* board, const int* rows, int count)
+{
+    // From the top down: deleting a row does not move the ones under it
+    int sorted[4];
+    int sorted_count = 0;
+    for (int i = 0; i < count; ++i) {
+        int at = sorted_count;
+        while (at > 0 && sorted[at - 1] < rows[i]) {
+            --at;
+        }
+        if (at > 0 && sorted[at - 1] == rows[i]) {
+            continue;
+        }
+        memmove(&sorted[at + 1], &sorted[at], sizeof(int) * (sorted_count - at));
+        sorted[at] = rows[i];
+        ++sorted_count;
+    }
+
+    int deleted_rows = 0;
+    for (int i = 0; i < sorted_count; ++i) {
+        int row = sorted[i];
+        if (row >= board->height) {
+            continue;
+        }
+        Slot* slots = EndlessBoard_row(board, row);
+        bool full_row = true;
+        for (int col = 0; col < board->cols; ++col) {
+            if (!slots[col].active) {
+                full_row = false;
+                break;
+            }
+        }
+        if (!full_row) {
+            continue;
+        }
+        deleted_rows += 1;
+
+        // The rows above fall by moving their indices, the deleted one becomes the first
+        // empty row
+        uint32_t index = board->rows[row];
+        memmove(&board->rows[row], &board->rows[row + 1], sizeof(uint32_t) * (board->height - 1 - row));
+        board->rows[board->height - 1] = index;
+        for (int col = 0; col < board->cols; ++col) {
+            slots[col] = (Slot) { .active = false, .type = Empty };
+        }
+        board->height -= 1;
+
+        // Columns with a square above fall by 1, the ones that ended on the deleted row
+        // look for their new top under it
+        for (int col = 0; col < board->cols; ++col) {
+            if (board->column_heights[col] > row + 1) {
+                board->column_heights[col] -= 1;
+                continue;
+            }
+            int height = row;
+            while (height > 0 && !EndlessBoard_row(board, height - 1)[col].active) {
+                --height;
+            }
+            board->column_heights[col] = height;
+        }
+    }
+
+    if (deleted_rows > 0) {
+        board->height = 0;
+        for (int col = 0; col < board->cols; ++col) {
+            if (board->column_heights[col] > board->height) {
+                board->height = board->column_heights[col];
+            }
+        }
+    }
+    return deleted_rows;
+}
+
+bool EndlessGame_init(EndlessGame* game, int level, uint64_t seed, Randomizer randomizer, int max_rows, int cols, int garbage_rows)
+{
+    *game = (EndlessGame) { .garbage_rows = garbage_rows };
+    EndlessBoard_init(&game->board, max_rows, cols);
+    return EndlessGame_start(game, level, seed, randomizer);
+}
+
+void EndlessGame_free(EndlessGame* game)
+{
+    EndlessBoard_free(&game->board);
+}
+
+bool EndlessGame_reset(EndlessGame* game, int start_level)
+{
+    int best_score = game->rules.score > game->rules.best_score ? game->rules.score : game->rules.best_score;
+    int preview_length = game->rules.preview_length;
+
+    // The chunks of the last game are kept, only the rows it used are emptied
+    EndlessBoard_clear(&game->board);
+    bool started = EndlessGame_start(game, start_level, Rng_next(&game->rules.rng), game->rules.randomizer);
+    game->rules.best_score = best_score;
+    Game_set_preview_length(&game->rules, preview_length);
+    return started;
+}
+
+bool EndlessGame_start(EndlessGame* game, int level, uint64_t seed, Randomizer randomizer)
+{
+    EndlessBoard* board = &game->board;
+    game->rules = Game_init_sized(level, seed, randomizer, ROWS, board->cols);
+    game->game_over = true;
+
+    // Garbage from a generator of its own: the pieces are the ones of a Game with the same seed
+    int garbage_rows = game->garbage_rows;
+    if (garbage_rows > board->max_rows - ENDLESS_SPAWN_GAP - 4) {
+        garbage_rows = board->max_rows - ENDLESS_SPAWN_GAP - 4;
+    }
+    if (garbage_rows > 0 && !EndlessBoard_reserve(board, garbage_rows)) {
+        return false;
+    }
+    Rng rng = Rng_seed(~seed);
+    for (int row = 0; row < garbage_rows; ++row) {
+        int hole = (int)(Rng_next(&rng) % (uint64_t)board->cols);
+        PieceKind kind = PieceKind_get_random(&rng);
+        for (int col = 0; col < board->cols; ++col) {
+            if (col != hole) {
+                EndlessBoard_set(board, row, col, kind);
+            }
+        }
+    }
+
+    game->game_over = !EndlessGame_spawn_piece(game, game->rules.active_piece.kind);
+    return true;
+}
+
+bool EndlessGame_fits(const EndlessGame* game, const Square squares[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        if (EndlessBoard_occupied(&game->board, squares[i][0], squares[i][1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EndlessGame_spawn_piece(EndlessGame* game, PieceKind kind)
+{
+    // Spawn rows are 2 and 3 counting down, the bottom one goes on the gap
+    Piece piece = Piece_spawn_centered(kind, game->board.cols);
+    for (int i = 0; i < ARRAY_LEN_INT(piece.squares); ++i) {
+        piece.squares[i][0] = game->board.height + ENDLESS_SPAWN_GAP + 3 - piece.squares[i][0];
+    }
+    game->active_piece = piece;
+    return EndlessGame_fits(game, (const Square*)piece.squares);
+}
+
+bool EndlessGame_move_active_piece(EndlessGame* game, Direction direction)
+{
+    Piece moved = game->active_piece;
+    for (int i = 0; i < ARRAY_LEN_INT(moved.squares); ++i) {
+        moved.squares[i][1] += direction == Left ? -1 : 1;
+    }
+    if (!EndlessGame_fits(game, (const Square*)moved.squares)) {
+        return false;
+    }
+    game->active_piece = moved;
+    return true;
+}
+
+bool EndlessGame_rotate_active_piece(EndlessGame* game, Direction direction)
+{
+    // A quarter turn around the second square as Piece_rotate, with the rows going up
+    const Square* origin = &game->active_piece.squares[1];
+    Piece rotated = game->active_piece;
+    for (int i = 0; i < ARRAY_LEN_INT(rotated.squares); ++i) {
+        int row = game->active_piece.squares[i][0] - (*origin)[0];
+        int col = game->active_piece.squares[i][1] - (*origin)[1];
+        rotated.squares[i][0] = (*origin)[0] + (direction == Right ? col : -col);
+        rotated.squares[i][1] = (*origin)[1] + (direction == Right ? -row : row);
+    }
+    if (!EndlessGame_fits(game, (const Square*)rotated.squares)) {
+        return false;
+    }
+    game->active_piece = rotated;
+    return true;
+}
+
+bool EndlessGame_gravity_active_piece(EndlessGame* game)
+{
+    Piece fallen = game->active_piece;
+    for (int i = 0; i < ARRAY_LEN_INT(fallen.squares); ++i) {
+        fallen.squares[i][0] -= 1;
+    }
+    if (!EndlessGame_fits(game, (const Square*)fallen.squares)) {
+        return true;
+    }
+    game->active_piece = fallen;
+    return false;
+}
+
+int EndlessGame_drop_distance(const EndlessGame* game)
+{
+    const Piece* piece = &game->active_piece;
+    int distance = game->board.max_rows;
+
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        int row = piece->squares[i][0];
+        int height = game->board.column_heights[piece->squares[i][1]];
+        if (row < height) {
+            // Under an overhang: the column height says nothing, step down
+            distance = -1;
+            break;
+        }
+        if (row - height < distance) {
+            distance = row - height;
+        }
+    }
+    if (distance >= 0) {
+        return distance;
+    }
+
+    for (distance = 0;; ++distance) {
+        for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+            if (EndlessBoard_occupied(&game->board, piece->squares[i][0] - distance - 1, piece->squares[i][1])) {
+                return distance;
+            }
+        }
+    }
+}
+
+void EndlessGame_hard_drop_active_piece(EndlessGame* game)
+{
+    int distance = EndlessGame_drop_distance(game);
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        game->active_piece.squares[i][0] -= distance;
+    }
+}
+
+int EndlessGame_lock_active_piece(EndlessGame* game, int start_level, bool* next_level)
+{
+    EndlessBoard* board = &game->board;
+    const Piece* piece = &game->active_piece;
+    int rows[4];
+    int top = 0;
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        rows[i] = piece->squares[i][0];
+        if (rows[i] > top) {
+            top = rows[i];
+        }
+    }
+    if (next_level != nullptr) {
+        *next_level = false;
+    }
+    if (!EndlessBoard_reserve(board, top + 1)) {
+        game->game_over = true;
+        return 0;
+    }
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        EndlessBoard_set(board, piece->squares[i][0], piece->squares[i][1], piece->kind);
+    }
+
+    int deleted_rows = EndlessBoard_delete_full_rows(board, rows, ARRAY_LEN_INT(rows));
+    game->rules.destroyed_lines += deleted_rows;
+    Game_update_score(&game->rules, deleted_rows);
+    bool level_changed = Game_check_next_level(&game->rules, start_level);
+    if (next_level != nullptr) {
+        *next_level = level_changed;
+    }
+
+    game->game_over = !EndlessGame_spawn_piece(game, Game_pop_kind(&game->rules));
+    return deleted_rows;
+}
+
+int EndlessGame_camera_target(const EndlessGame* game, int view_rows)
+{
+    const Piece* piece = &game->active_piece;
+    int top = piece->squares[0][0];
+    int bottom = piece->squares[0][0];
+    for (int i = 1; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        top = piece->squares[i][0] > top ? piece->squares[i][0] : top;
+        bottom = piece->squares[i][0] < bottom ? piece->squares[i][0] : bottom;
+    }
+
+    // The stack under where the piece lands, unless the view is too short for the piece
+    int camera = bottom - EndlessGame_drop_distance(game) - ENDLESS_CAMERA_MARGIN;
+    if (top + 1 + ENDLESS_CAMERA_MARGIN > camera + view_rows) {
+        camera = top + 1 + ENDLESS_CAMERA_MARGIN - view_rows;
+    }
+    return camera > 0 ? camera : 0;
+}
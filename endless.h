@@ -0,0 +1,120 @@
+#ifndef ENDLESS_H_
+#define ENDLESS_H_
+
+#include "game.h"
+
+/*
+    Endless mode: a board thousands of rows tall, seen through a window of a few rows that
+    scrolls with the active piece. Game is a fixed matrix swept whole by every deletion
+    (O(rows^2)), so the tall board has its own storage:
+    - rows are allocated in chunks of ENDLESS_CHUNK_ROWS rows when the stack reaches them,
+      a chunk never moves once allocated
+    - the board is a table from the logical row (0 is the bottom) to the row in the chunks.
+      Deleting a row moves the indices of the rows above it down by one (4 bytes each,
+      only up to the top of the stack) and the deleted row is recycled as the first empty one
+    - the height of every column is kept up to date, so the drop distance and the top
+      of the stack never scan the board
+    - only the rows that touch the piece are checked for a line clear
+
+    Coordinates are { row from the bottom, column }: the rows go up, a piece spawns
+    ENDLESS_SPAWN_GAP rows over the stack.
+*/
+
+#define ENDLESS_CHUNK_ROWS 256
+#define ENDLESS_ROWS_MIN 64
+#define ENDLESS_ROWS_MAX (1 << 20)
+#define ENDLESS_SPAWN_GAP 12 // empty rows between the top of the stack and a new piece
+#define ENDLESS_CAMERA_MARGIN 2 // rows shown under the landing of the piece and over it
+
+typedef struct {
+    int cols;
+    int max_rows; // the board never grows over it
+    int height; // rows up to the highest occupied square, all the rows over it are empty
+    Slot** chunks; // ENDLESS_CHUNK_ROWS * cols slots each
+    int chunk_count;
+    uint32_t* rows; // logical row -> row in the chunks, chunk_count * ENDLESS_CHUNK_ROWS of them
+    int column_heights[COLS_MAX]; // highest occupied row + 1 of every column, 0 if empty
+} EndlessBoard;
+
+typedef struct {
+    EndlessBoard board;
+    Game rules; // queue, score, lines and level, its board is not used
+    Piece active_piece;
+    int garbage_rows; // at the bottom of a new board, one hole each
+    bool game_over; // the stack reached the top of the board
+} EndlessGame;
+
+/// BOARD
+
+/*
+    Empty board of max_rows x cols, no chunk is allocated until it is needed
+*/
+void EndlessBoard_init(EndlessBoard* board, int max_rows, int cols);
+void EndlessBoard_free(EndlessBoard* board);
+
+/*
+    Allocate the chunks up to row (excluded). Return false if they do not fit in max_rows or
+    in memory
+*/
+bool EndlessBoard_reserve(EndlessBoard* board, int rows);
+
+/*
+    The cols slots of a logical row, row < the reserved rows
+*/
+Slot* EndlessBoard_row(const EndlessBoard* board, int row);
+
+/*
+    True if the square is occupied or out of the board (walls and floor)
+*/
+bool EndlessBoard_occupied(const EndlessBoard* board, int row, int col);
+
+/*
+    Delete the full rows among rows[count] (the rows of a piece, any order): the rows over
+    them fall. Return how many
+*/
+int EndlessBoard_delete_full_rows(EndlessBoard* board, const int* rows, int count);
+
+/// GAME
+
+/*
+    New game on a board of max_rows x cols (within the MIN and MAX rows and cols) with
+    garbage_rows of garbage at the bottom. Return false if the memory is not enough
+*/
+bool EndlessGame_init(EndlessGame* game, int level, uint64_t seed, Randomizer randomizer, int max_rows, int cols, int garbage_rows);
+void EndlessGame_free(EndlessGame* game);
+
+/*
+    Start again on the same board size, seeded by the game as Game_reset
+*/
+bool EndlessGame_reset(EndlessGame* game, int start_level);
+
+bool EndlessGame_move_active_piece(EndlessGame* game, Direction direction);
+bool EndlessGame_rotate_active_piece(EndlessGame* game, Direction direction);
+
+/*
+    Move the active piece down by 1. Return true if it touched instead
+*/
+bool EndlessGame_gravity_active_piece(EndlessGame* game);
+
+/*
+    Rows the active piece can fall before touching, from the column heights unless the
+    piece is under an overhang
+*/
+int EndlessGame_drop_distance(const EndlessGame* game);
+
+void EndlessGame_hard_drop_active_piece(EndlessGame* game);
+
+/*
+    Release the active piece, delete the full rows, update score and level and spawn the
+    next piece. Return the number of deleted rows, next_level (if not nullptr) tells if
+    the level changed
+*/
+int EndlessGame_lock_active_piece(EndlessGame* game, int start_level, bool* next_level);
+
+/*
+    Lowest row of the view of view_rows rows that shows where the active piece lands and
+    the piece itself, with a margin. 0 while they fit from the bottom
+*/
+int EndlessGame_camera_target(const EndlessGame* game, int view_rows);
+
+#endif // ENDLESS_H_
@@ -0,0 +1,439 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cetris_env.h"
+#include "cetris_envd.h"
+
+/*
+    cetris-envd: host a pool of environments for trainers running in other processes.
+    Clients attach through the shared memory segment described in cetris_envd.h, the
+    server sleeps on the doorbell futex until some requests are pending, waits up to the
+    batch window for the other attached clients (not for the ones that missed the last
+    window, until they send a request again), then serves every pending request with
+    one step per run of contiguous slots, writing straight into the shared buffers.
+*/
+
+// Seconds between the checks for dead clients, idle or under load
+#define RECLAIM_INTERVAL 1.0
+
+typedef struct {
+    const char* name;
+    int clients;
+    int envs_per_client;
+    int start_level;
+    int randomizer;
+    int auto_reset;
+    uint64_t seed;
+    int batch_window_us;
+} EnvdConfig;
+
+typedef struct {
+    CetrisEnvdHeader* header;
+    CetrisEnvdSlot* slots;
+    uint8_t* base;
+    CetrisEnv* env;
+    uint32_t* served; // last request served of every slot
+    uint32_t* requests; // request seen by the last collect of every slot, served[i] if none
+    uint8_t* missed; // 1 if the slot sent nothing within the last batch window
+    uint64_t env_steps;
+} Envd;
+
+volatile sig_atomic_t stop_requested = 0;
+
+void usage(const char* program);
+bool parse_args(int argc, char** argv, EnvdConfig* config);
+void on_signal(int signal);
+double now_seconds(void);
+
+/*
+    Unlink the segment name if it was left by a server that is dead. Return false if a
+    live server still owns it
+*/
+bool Envd_unlink_stale(const char* name);
+
+/*
+    Load the request of every slot, return how many are pending. expected is the number
+    of attached slots worth waiting for: pending or not missed
+*/
+int Envd_collect(Envd* envd, int* expected);
+
+/*
+    Mark the attached slots without a pending request as missed, the next batch windows
+    do not wait for them until they send one
+*/
+void Envd_mark_missed(Envd* envd);
+
+/*
+    Serve the pending requests of the slots in [first, last), that all have the same command
+*/
+void Envd_serve_run(Envd* envd, int first, int last, uint32_t command);
+
+/*
+    Serve every pending request, coalescing contiguous slots with the same command
+*/
+void Envd_serve(Envd* envd);
+
+/*
+    Free the slots of the clients that died without disconnecting
+*/
+void Envd_reclaim(Envd* envd);
+
+int main(int argc, char** argv)
+{
+    EnvdConfig config = {
+        .name = CETRIS_ENVD_DEFAULT_NAME,
+        .clients = 8,
+        .envs_per_client = 256,
+        .start_level = 0,
+        .randomizer = CETRIS_ENV_RANDOMIZER_UNIFORM,
+        .auto_reset = 1,
+        .seed = (uint64_t)time(NULL),
+        .batch_window_us = 50,
+    };
+    if (!parse_args(argc, argv, &config)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    CetrisEnvdHeader layout = {
+        .num_clients = config.clients,
+        .envs_per_client = config.envs_per_client,
+    };
+    cetris_envd_layout(&layout);
+
+    // A segment left by a server that was killed is replaced, a running one is not
+    if (!Envd_unlink_stale(config.name)) {
+        return 1;
+    }
+    int fd = shm_open(config.name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)layout.size) != 0) {
+        fprintf(stderr, "ERROR: cannot create the shared memory %s\n", config.name);
+        return 1;
+    }
+    uint8_t* base = mmap(nullptr, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "ERROR: cannot map the shared memory %s\n", config.name);
+        shm_unlink(config.name);
+        return 1;
+    }
+
+    CetrisEnvConfig env_config = {
+        .num_envs = config.clients * config.envs_per_client,
+        .start_level = config.start_level,
+        .randomizer = config.randomizer,
+        .auto_reset = config.auto_reset,
+        .seed = config.seed,
+    };
+    Envd envd = {
+        .header = (CetrisEnvdHeader*)base,
+        .slots = (CetrisEnvdSlot*)(base + layout.slots_offset),
+        .base = base,
+        .env = cetris_env_create(&env_config),
+        .served = calloc((size_t)config.clients, sizeof(uint32_t)),
+        .requests = calloc((size_t)config.clients, sizeof(uint32_t)),
+        .missed = calloc((size_t)config.clients, sizeof(uint8_t)),
+    };
+    if (envd.env == nullptr || envd.served == nullptr || envd.requests == nullptr || envd.missed == nullptr) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        shm_unlink(config.name);
+        return 1;
+    }
+
+    // The segment is zero filled: every slot is free, the counters start from 0
+    CetrisEnvdHeader* header = envd.header;
+    *header = layout;
+    header->version = CETRIS_ENVD_VERSION;
+    header->api_version = CETRIS_ENV_API_VERSION;
+    header->server_pid = (int32_t)getpid();
+    atomic_store(&header->running, 1);
+    // The magic is the last thing written, a client that sees it sees the whole header
+    atomic_thread_fence(memory_order_release);
+    header->magic = CETRIS_ENVD_MAGIC;
+
+    struct sigaction action = { .sa_handler = on_signal };
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    printf("cetris-envd: %s, %d clients x %d environments (%.1f MiB)\n",
+        config.name, config.clients, config.envs_per_client, (double)layout.size / (1 << 20));
+    fflush(stdout);
+
+    double start = now_seconds();
+    double last_reclaim = start;
+
+    while (!stop_requested) {
+        // Also under load: a dead client still counts as attached, and every step would
+        // wait the whole batch window for it
+        double now = now_seconds();
+        if (now - last_reclaim > RECLAIM_INTERVAL) {
+            Envd_reclaim(&envd);
+            last_reclaim = now;
+        }
+
+        uint32_t doorbell = atomic_load(&header->doorbell);
+        int expected = 0;
+        int pending = Envd_collect(&envd, &expected);
+
+        if (pending == 0) {
+            // Sequentially consistent with the clients: either they see sleeping or we
+            // see the new doorbell
+            atomic_store(&header->sleeping, 1);
+            if (atomic_load(&header->doorbell) == doorbell) {
+                cetris_envd_futex_wait(&header->doorbell, doorbell, 100);
+            }
+            atomic_store(&header->sleeping, 0);
+            continue;
+        }
+
+        // Give the other attached clients a chance to join the same step. An idle client
+        // costs one window, then it is not waited for until its next request
+        if (pending < expected && config.batch_window_us > 0) {
+            double deadline = now_seconds() + config.batch_window_us * 1e-6;
+            while (pending < expected && now_seconds() < deadline) {
+                pending = Envd_collect(&envd, &expected);
+            }
+            Envd_mark_missed(&envd);
+        }
+
+        Envd_serve(&envd);
+    }
+
+    double elapsed = now_seconds() - start;
+    printf("cetris-envd: %llu environment steps in %.1fs (%.0f steps/s)\n",
+        (unsigned long long)envd.env_steps, elapsed, elapsed > 0 ? (double)envd.env_steps / elapsed : 0.0);
+
+    // Wake every waiting client, they see running == 0 and fail the request
+    atomic_store(&header->running, 0);
+    for (int i = 0; i < config.clients; ++i) {
+        cetris_envd_futex_wake(&envd.slots[i].response, 1);
+    }
+    shm_unlink(config.name);
+    munmap(base, layout.size);
+    cetris_env_destroy(envd.env);
+    free(envd.served);
+    free(envd.requests);
+    free(envd.missed);
+    return 0;
+}
+
+//              //
+//              //
+//  FUNCTIONS   //
+//              //
+//              //
+
+void usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n <name>         shared memory name (default " CETRIS_ENVD_DEFAULT_NAME ")\n"
+        "  -c <clients>      client slots (default 8)\n"
+        "  -e <envs>         environments per client (default 256)\n"
+        "  -l <level>        start level 0-9 (default 0)\n"
+        "  -r <randomizer>   uniform|bag|nes (default uniform)\n"
+        "  -a <0|1>          reset the environments that end inside the step (default 1)\n"
+        "  -s <seed>         seed (default: time)\n"
+        "  -w <us>           batch window: how long to wait for the other clients (default 50)\n",
+        program);
+}
+
+bool parse_args(int argc, char** argv, EnvdConfig* config)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 'n':
+            config->name = value;
+            break;
+        case 'c':
+            config->clients = atoi(value);
+            break;
+        case 'e':
+            config->envs_per_client = atoi(value);
+            break;
+        case 'l':
+            config->start_level = atoi(value);
+            break;
+        case 'r':
+            if (strcmp(value, "uniform") == 0) {
+                config->randomizer = CETRIS_ENV_RANDOMIZER_UNIFORM;
+            } else if (strcmp(value, "bag") == 0) {
+                config->randomizer = CETRIS_ENV_RANDOMIZER_BAG;
+            } else if (strcmp(value, "nes") == 0) {
+                config->randomizer = CETRIS_ENV_RANDOMIZER_NES;
+            } else {
+                return false;
+            }
+            break;
+        case 'a':
+            config->auto_reset = atoi(value);
+            break;
+        case 's':
+            config->seed = strtoull(value, nullptr, 10);
+            break;
+        case 'w':
+            config->batch_window_us = atoi(value);
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return config->name[0] == '/' && config->clients > 0 && config->envs_per_client > 0
+        && config->start_level >= 0 && config->start_level <= 9 && config->batch_window_us >= 0;
+}
+
+void on_signal(int signal)
+{
+    (void)signal;
+    stop_requested = 1;
+}
+
+double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+bool Envd_unlink_stale(const char* name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return true;
+    }
+
+    struct stat info;
+    int32_t pid = 0;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(CetrisEnvdHeader)) {
+        const CetrisEnvdHeader* header = mmap(nullptr, sizeof(CetrisEnvdHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (header != MAP_FAILED) {
+            // Without the magic the server died before the end of its setup
+            pid = header->magic == CETRIS_ENVD_MAGIC ? header->server_pid : 0;
+            munmap((void*)header, sizeof(CetrisEnvdHeader));
+        }
+    }
+    close(fd);
+
+    // Only ESRCH means dead: EPERM is a live process of another user
+    if (pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH)) {
+        fprintf(stderr, "ERROR: %s is served by cetris-envd %d, stop it or use another name (-n)\n", name, (int)pid);
+        return false;
+    }
+    shm_unlink(name);
+    return true;
+}
+
+int Envd_collect(Envd* envd, int* expected)
+{
+    int pending = 0;
+    *expected = 0;
+    for (int i = 0; i < envd->header->num_clients; ++i) {
+        CetrisEnvdSlot* slot = &envd->slots[i];
+        bool attached = atomic_load_explicit(&slot->state, memory_order_relaxed) == CETRIS_ENVD_SLOT_ATTACHED;
+        // Acquire: the command and the actions of the request are visible after this
+        envd->requests[i] = atomic_load_explicit(&slot->request, memory_order_acquire);
+        bool is_pending = envd->requests[i] != envd->served[i];
+        if (is_pending) {
+            envd->missed[i] = 0;
+        }
+        pending += is_pending;
+        *expected += attached && (is_pending || !envd->missed[i]);
+    }
+    return pending;
+}
+
+void Envd_mark_missed(Envd* envd)
+{
+    for (int i = 0; i < envd->header->num_clients; ++i) {
+        if (envd->requests[i] == envd->served[i]
+            && atomic_load_explicit(&envd->slots[i].state, memory_order_relaxed) == CETRIS_ENVD_SLOT_ATTACHED) {
+            envd->missed[i] = 1;
+        }
+    }
+}
+
+void Envd_serve_run(Envd* envd, int first, int last, uint32_t command)
+{
+    const CetrisEnvdHeader* header = envd->header;
+    uint8_t* base = envd->base;
+    int32_t first_env = first * header->envs_per_client;
+    int32_t last_env = last * header->envs_per_client;
+    size_t envs = (size_t)(last_env - first_env);
+
+    float* rewards = (float*)(base + header->rewards_offset) + first_env;
+    uint8_t* dones = base + header->dones_offset + first_env;
+
+    if (command == CETRIS_ENVD_COMMAND_RESET) {
+        cetris_env_reset_range(envd->env, first_env, last_env, base + header->reset_mask_offset + first_env);
+        memset(rewards, 0, envs * sizeof(float));
+        memset(dones, 0, envs);
+    } else {
+        cetris_env_step_range(envd->env, first_env, last_env, base + header->actions_offset + first_env, rewards, dones);
+        envd->env_steps += envs;
+    }
+
+    CetrisObservation observation = {
+        .board = base + header->board_offset + (size_t)first_env * CETRIS_ENV_PLANES * CETRIS_ENV_ROWS * CETRIS_ENV_COLS,
+        .pieces = (int8_t*)(base + header->pieces_offset) + (size_t)first_env * CETRIS_ENV_PIECES,
+        .scalars = (float*)(base + header->scalars_offset) + (size_t)first_env * CETRIS_ENV_SCALARS,
+    };
+    cetris_env_observe_range(envd->env, first_env, last_env, &observation);
+
+    for (int i = first; i < last; ++i) {
+        CetrisEnvdSlot* slot = &envd->slots[i];
+        envd->served[i] = envd->requests[i];
+        // Release: the client sees the buffers once it sees the response
+        atomic_store(&slot->response, envd->requests[i]);
+        if (atomic_load(&slot->waiting) != 0) {
+            cetris_envd_futex_wake(&slot->response, 1);
+        }
+    }
+}
+
+void Envd_serve(Envd* envd)
+{
+    int clients = envd->header->num_clients;
+    int first = 0;
+    while (first < clients) {
+        if (envd->requests[first] == envd->served[first]) {
+            first += 1;
+            continue;
+        }
+        uint32_t command = envd->slots[first].command;
+        int last = first + 1;
+        while (last < clients && envd->requests[last] != envd->served[last] && envd->slots[last].command == command) {
+            last += 1;
+        }
+        Envd_serve_run(envd, first, last, command);
+        first = last;
+    }
+}
+
+void Envd_reclaim(Envd* envd)
+{
+    for (int i = 0; i < envd->header->num_clients; ++i) {
+        CetrisEnvdSlot* slot = &envd->slots[i];
+        int32_t pid = slot->pid;
+        if (atomic_load(&slot->state) == CETRIS_ENVD_SLOT_ATTACHED && pid != 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+            fprintf(stderr, "cetris-envd: client %d (pid %d) died, slot freed\n", i, (int)pid);
+            slot->pid = 0;
+            atomic_store(&slot->state, CETRIS_ENVD_SLOT_FREE);
+        }
+    }
+}
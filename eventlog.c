@@ -0,0 +1,176 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "eventlog.h"
+
+// Longest line of an event, the writer flushes its buffer before it can overflow
+#define EVENT_LINE_MAX 192
+#define EVENT_LOG_BUFFER (64 * 1024)
+
+/*
+    Writer thread: drain the ring in batches until the log is closed and empty
+*/
+void* EventLog_writer(void* arg);
+
+/*
+    Format event as a JSON line into out, return its length
+*/
+int Event_format(const Event* event, char* out, int size);
+
+bool EventLog_open(EventLog* log, const char* path)
+{
+    memset(log, 0, sizeof(*log));
+#ifdef __EMSCRIPTEN__
+    (void)path;
+    return false;
+#else
+    log->file = fopen(path, "a");
+    if (log->file == nullptr) {
+        return false;
+    }
+
+    atomic_store(&log->running, true);
+    if (pthread_create(&log->writer, nullptr, EventLog_writer, log) != 0) {
+        fclose(log->file);
+        log->file = nullptr;
+        return false;
+    }
+    return true;
+#endif
+}
+
+void EventLog_close(EventLog* log)
+{
+    if (log->file == nullptr) {
+        return;
+    }
+    atomic_store(&log->running, false);
+    pthread_join(log->writer, nullptr);
+    fclose(log->file);
+    log->file = nullptr;
+}
+
+void EventLog_emit(EventLog* log, EventKind kind, const Game* game, float time, int32_t value)
+{
+    if (log == nullptr) {
+        return;
+    }
+    if (kind == EventGameStart) {
+        log->game += 1;
+        log->piece = 0;
+    } else if (kind == EventSpawn) {
+        log->piece += 1;
+    }
+
+    uint32_t head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&log->tail, memory_order_acquire);
+    if (head - tail == EVENT_LOG_CAPACITY) {
+        atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    Event* event = &log->events[head & (EVENT_LOG_CAPACITY - 1)];
+    *event = (Event) {
+        .time = time,
+        .game = log->game,
+        .piece = log->piece,
+        .kind = (uint8_t)kind,
+        .piece_kind = (uint8_t)game->active_piece.kind,
+        .value = value,
+    };
+    for (int i = 0; i < ARRAY_LEN_INT(event->squares); ++i) {
+        event->squares[i][0] = (int8_t)game->active_piece.squares[i][0];
+        event->squares[i][1] = (int8_t)game->active_piece.squares[i][1];
+    }
+    atomic_store_explicit(&log->head, head + 1, memory_order_release);
+}
+
+void EventLog_game_start(EventLog* log, const Game* game, int start_level)
+{
+    EventLog_emit(log, EventGameStart, game, 0.0f, start_level);
+    EventLog_emit(log, EventSpawn, game, 0.0f, 0);
+}
+
+void* EventLog_writer(void* arg)
+{
+    EventLog* log = arg;
+    char* buffer = malloc(EVENT_LOG_BUFFER);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    while (true) {
+        // Read before draining: what was emitted before the close is still written
+        bool running = atomic_load(&log->running);
+        uint32_t tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&log->head, memory_order_acquire);
+
+        int length = 0;
+        for (; tail != head; ++tail) {
+            length += Event_format(&log->events[tail & (EVENT_LOG_CAPACITY - 1)], buffer + length, EVENT_LOG_BUFFER - length);
+            if (EVENT_LOG_BUFFER - length < EVENT_LINE_MAX) {
+                fwrite(buffer, 1, (size_t)length, log->file);
+                length = 0;
+            }
+        }
+        atomic_store_explicit(&log->tail, tail, memory_order_release);
+
+        uint32_t dropped = atomic_exchange_explicit(&log->dropped, 0, memory_order_relaxed);
+        if (dropped > 0) {
+            length += snprintf(buffer + length, (size_t)(EVENT_LOG_BUFFER - length), "{\"event\":\"dropped\",\"count\":%u}\n", dropped);
+        }
+
+        if (length > 0) {
+            fwrite(buffer, 1, (size_t)length, log->file);
+            fflush(log->file);
+        } else if (!running) {
+            break;
+        } else {
+            nanosleep(&(struct timespec) { .tv_nsec = EVENT_LOG_SLEEP_MS * 1000000L }, nullptr);
+        }
+    }
+
+    free(buffer);
+    return nullptr;
+}
+
+int Event_format(const Event* event, char* out, int size)
+{
+    const char* names[] = {
+        [EventGameStart] = "start",
+        [EventSpawn] = "spawn",
+        [EventLock] = "lock",
+        [EventLineClear] = "line_clear",
+        [EventLevel] = "level",
+        [EventScore] = "score",
+        [EventGameOver] = "game_over",
+    };
+    char kind = event->piece_kind < Empty ? "TJZOSLI"[event->piece_kind] : '.';
+
+    int length = snprintf(out, (size_t)size, "{\"t\":%.3f,\"game\":%u,\"piece\":%u,\"event\":\"%s\"", event->time, event->game, event->piece, names[event->kind]);
+    switch ((EventKind)event->kind) {
+    case EventGameStart:
+    case EventLevel:
+        length += snprintf(out + length, (size_t)(size - length), ",\"level\":%d}\n", event->value);
+        break;
+    case EventSpawn:
+        length += snprintf(out + length, (size_t)(size - length), ",\"kind\":\"%c\"}\n", kind);
+        break;
+    case EventLock:
+        length += snprintf(out + length, (size_t)(size - length), ",\"kind\":\"%c\",\"squares\":[[%d,%d],[%d,%d],[%d,%d],[%d,%d]]}\n", kind,
+            event->squares[0][0], event->squares[0][1], event->squares[1][0], event->squares[1][1],
+            event->squares[2][0], event->squares[2][1], event->squares[3][0], event->squares[3][1]);
+        break;
+    case EventLineClear:
+        length += snprintf(out + length, (size_t)(size - length), ",\"lines\":%d}\n", event->value);
+        break;
+    case EventScore:
+    case EventGameOver:
+        length += snprintf(out + length, (size_t)(size - length), ",\"score\":%d}\n", event->value);
+        break;
+    }
+    return length;
+}
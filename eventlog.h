@@ -0,0 +1,84 @@
+#ifndef EVENTLOG_H_
+#define EVENTLOG_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+
+/*
+    Structured log of what happens in the games, one JSON object per line:
+
+    {"t":12.350,"game":1,"piece":31,"event":"lock","kind":"T","squares":[[21,4],[20,4],[20,3],[20,5]]}
+
+    The game only copies fixed size events into a lock free single producer single
+    consumer ring, a writer thread formats them in batches and writes them to the file. The
+    game never waits for the disk: when the ring is full the event is dropped and the
+    writer logs how many were lost.
+
+    Not available on the web, where there are no threads.
+*/
+
+#define EVENT_LOG_CAPACITY 4096 // power of 2
+#define EVENT_LOG_SLEEP_MS 10 // writer pause when the ring is empty
+
+typedef enum {
+    EventGameStart, // value is the start level
+    EventSpawn,
+    EventLock, // squares of the piece where it locked
+    EventLineClear, // value is the deleted lines
+    EventLevel, // value is the new level
+    EventScore, // value is the new score
+    EventGameOver, // value is the final score
+} EventKind;
+
+typedef struct {
+    float time; // seconds played in the game
+    uint32_t game; // games of the session, from 1
+    uint32_t piece; // pieces of the game, from 1
+    uint8_t kind;
+    uint8_t piece_kind;
+    int8_t squares[4][2];
+    int32_t value;
+} Event;
+
+typedef struct {
+    Event events[EVENT_LOG_CAPACITY];
+    _Atomic uint32_t head; // written by the game
+    _Atomic uint32_t tail; // written by the writer
+    _Atomic uint32_t dropped;
+    _Atomic bool running;
+
+    FILE* file;
+    pthread_t writer;
+
+    // Game side counters
+    uint32_t game;
+    uint32_t piece;
+} EventLog;
+
+/*
+    Append to path and start the writer. Return false if the file cannot be opened or the
+    thread cannot start
+*/
+bool EventLog_open(EventLog* log, const char* path);
+
+/*
+    Write what is left and stop the writer
+*/
+void EventLog_close(EventLog* log);
+
+/*
+    Log an event of game at time, the piece of the spawn and lock events is the active
+    piece. Never blocks, does nothing if log is nullptr
+*/
+void EventLog_emit(EventLog* log, EventKind kind, const Game* game, float time, int32_t value);
+
+/*
+    A new game started: its start event and the spawn of the first piece
+*/
+void EventLog_game_start(EventLog* log, const Game* game, int start_level);
+
+#endif // EVENTLOG_H_
@@ -0,0 +1,768 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846f
+#endif
+
+/*
+    Little bit stream used to (un)pack snapshots, LSB first
+*/
+typedef struct {
+    uint8_t* bytes;
+    int capacity;
+    int bit;
+} BitStream;
+
+void BitStream_write(BitStream* stream, uint64_t value, int bits);
+uint64_t BitStream_read(BitStream* stream, int bits, bool* ok);
+void BitStream_write_varint(BitStream* stream, uint32_t value);
+uint32_t BitStream_read_varint(BitStream* stream, bool* ok);
+
+/*
+    The board functions specialized for the standard board and generic for any size
+*/
+#define BOARD(name) name##_standard
+#define BOARD_ROWS(game) TOTAL_ROWS
+#define BOARD_COLS(game) COLS
+#if defined(__clang__)
+#define BOARD_UNROLL_COLS _Pragma("clang loop unroll(full)")
+#elif defined(__GNUC__)
+#define BOARD_UNROLL_COLS _Pragma("GCC unroll 16") // any count >= COLS unrolls it whole
+#else
+#define BOARD_UNROLL_COLS
+#endif
+#include "game_board.h"
+
+#define BOARD(name) name##_sized
+#define BOARD_ROWS(game) ((game)->rows + HIDDEN_ROWS)
+#define BOARD_COLS(game) ((game)->cols)
+#define BOARD_UNROLL_COLS
+#include "game_board.h"
+
+/*
+    Spawn position of every kind, the second square is the one Piece_rotate rotates around
+*/
+const Piece SPAWN_PIECES[Empty] = {
+    [T] = { .kind = T, .squares = { { 3, 5 }, { 2, 5 }, { 2, 4 }, { 2, 6 } } },
+    [J] = { .kind = J, .squares = { { 3, 4 }, { 3, 5 }, { 3, 6 }, { 2, 6 } } },
+    [Z] = { .kind = Z, .squares = { { 2, 6 }, { 2, 5 }, { 3, 4 }, { 3, 5 } } },
+    [O] = { .kind = O, .squares = { { 3, 4 }, { 3, 5 }, { 2, 4 }, { 2, 5 } } },
+    [S] = { .kind = S, .squares = { { 3, 6 }, { 3, 5 }, { 2, 5 }, { 2, 4 } } },
+    [L] = { .kind = L, .squares = { { 3, 4 }, { 3, 5 }, { 3, 6 }, { 2, 4 } } },
+    [I] = { .kind = I, .squares = { { 2, 4 }, { 2, 5 }, { 2, 6 }, { 2, 7 } } },
+};
+
+PieceKind PieceKind_get_random(Rng* rng)
+{
+    return (PieceKind)(Rng_next(rng) % Empty);
+}
+
+int Piece_left_square(Piece* piece)
+{
+    int min_col = 100;
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        if (piece->squares[i][1] < min_col) {
+            min_col = piece->squares[i][1];
+        }
+    }
+    return min_col;
+}
+
+int Piece_right_square(Piece* piece)
+{
+    int max_col = 0;
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        if (piece->squares[i][1] > max_col) {
+            max_col = piece->squares[i][1];
+        }
+    }
+    return max_col;
+}
+
+bool Piece_rotate(Piece* piece, float direction, Game* game)
+{
+    return Game_is_standard(game) ? Piece_rotate_standard(piece, direction, game) : Piece_rotate_sized(piece, direction, game);
+}
+
+Rng Rng_seed(uint64_t seed)
+{
+    // splitmix64 step, so that close seeds give unrelated states and the state is never 0
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (Rng) { .state = z != 0 ? z : 0x9E3779B97F4A7C15ull };
+}
+
+uint64_t Rng_next(Rng* rng)
+{
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return rng->state * 0x2545F4914F6CDD1Dull;
+}
+
+Piece Piece_spawn(PieceKind piece_kind_to_spawn)
+{
+    if (piece_kind_to_spawn >= Empty) {
+        printf("ERROR: Trying to spawn an EMPTY PIECE\n");
+        assert(false);
+    }
+
+    return SPAWN_PIECES[piece_kind_to_spawn];
+}
+
+Piece Piece_spawn_centered(PieceKind kind, int cols)
+{
+    Piece piece = Piece_spawn(kind);
+    if (cols == COLS) {
+        return piece;
+    }
+
+    // Centered as on the standard board, pushed back in on the narrow ones
+    int shift = (cols - COLS) / 2;
+    int right = Piece_right_square(&piece) + shift;
+    if (right >= cols) {
+        shift -= right - (cols - 1);
+    }
+    for (int i = 0; i < ARRAY_LEN_INT(piece.squares); ++i) {
+        piece.squares[i][1] += shift;
+    }
+    return piece;
+}
+
+Game Game_init(int level, uint64_t seed, Randomizer randomizer)
+{
+    return Game_init_sized(level, seed, randomizer, ROWS, COLS);
+}
+
+Game Game_init_sized(int level, uint64_t seed, Randomizer randomizer, int rows, int cols)
+{
+    assert(rows >= ROWS_MIN && rows <= ROWS_MAX && cols >= COLS_MIN && cols <= COLS_MAX);
+    Board board = { 0 };
+    for (int row = 0; row < ARRAY_LEN_INT(board); ++row) {
+        for (int col = 0; col < ARRAY_LEN_INT(board[col]); ++col) {
+            board[row][col].active = false;
+            board[row][col].type = Empty;
+        }
+    }
+
+    Game game = (Game) {
+        .rows = rows,
+        .cols = cols,
+        .destroyed_lines = 0,
+        .score = 0,
+        .best_score = 0,
+        .current_level = level,
+        .seed = seed,
+        .rng = Rng_seed(seed),
+        .randomizer = randomizer,
+        .bag = { Empty, Empty, Empty, Empty, Empty, Empty, Empty },
+        .bag_size = 0,
+        .queue_head = 0,
+        .queue_count = 0,
+        .preview_length = 1,
+    };
+    for (int i = 0; i < QUEUE_CAPACITY; ++i) {
+        game.queue[i] = Empty;
+    }
+    memcpy(game.board, board, sizeof(board));
+    for (int col = 0; col < cols; ++col) {
+        game.column_tops[col] = rows + HIDDEN_ROWS;
+    }
+    Game_fill_queue(&game);
+    game.active_piece = Game_spawn_piece(&game, Game_pop_kind(&game));
+
+    return game;
+}
+
+void Game_reset(Game* game, int start_level)
+{
+    int best_score = game->score > game->best_score ? game->score : game->best_score;
+    int preview_length = game->preview_length;
+
+    // The next game is seeded by this one, so a whole session is reproducible from the first seed
+    *game = Game_init_sized(start_level, Rng_next(&game->rng), game->randomizer, game->rows, game->cols);
+    game->best_score = best_score;
+    game->preview_length = preview_length;
+}
+
+bool Game_is_standard(const Game* game)
+{
+    return game->rows == ROWS && game->cols == COLS;
+}
+
+Piece Game_spawn_piece(const Game* game, PieceKind kind)
+{
+    return Piece_spawn_centered(kind, game->cols);
+}
+
+bool Game_touch_other_square(const Game* game, Square square)
+{
+    if (game->board[square[0]][square[1]].active == true) {
+        return true;
+    }
+    return false;
+}
+
+bool Game_active_piece_can_go_right(Game* game)
+{
+    return Game_is_standard(game) ? Game_active_piece_can_go_right_standard(game) : Game_active_piece_can_go_right_sized(game);
+}
+
+bool Game_active_piece_can_go_left(Game* game)
+{
+    int active_left = Piece_left_square(&game->active_piece);
+    if (active_left == 0)
+        return false;
+
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        Square next = { game->active_piece.squares[i][0], game->active_piece.squares[i][1] - 1 };
+        if (Game_touch_other_square(game, next)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Game_gravity_active_piece(Game* game)
+{
+    return Game_is_standard(game) ? Game_gravity_active_piece_standard(game) : Game_gravity_active_piece_sized(game);
+}
+
+int Game_drop_distance(const Game* game)
+{
+    return Game_is_standard(game) ? Game_drop_distance_standard(game) : Game_drop_distance_sized(game);
+}
+
+void Game_hard_drop_active_piece(Game* game)
+{
+    int distance = Game_drop_distance(game);
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        game->active_piece.squares[i][0] += distance;
+    }
+}
+
+void Game_compute_column_tops(Game* game)
+{
+    if (Game_is_standard(game)) {
+        Game_compute_column_tops_standard(game);
+    } else {
+        Game_compute_column_tops_sized(game);
+    }
+}
+
+void Game_release_active_piece(Game* game)
+{
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        Square* curr_square = &game->active_piece.squares[i];
+        memcpy(
+            (void*)&game->board[(*curr_square)[0]][(*curr_square)[1]],
+            &(Slot) { .active = true, .type = game->active_piece.kind },
+            sizeof(Slot));
+        game->hash ^= Zobrist_cell((*curr_square)[0], (*curr_square)[1]);
+        if ((*curr_square)[0] < game->column_tops[(*curr_square)[1]]) {
+            game->column_tops[(*curr_square)[1]] = (*curr_square)[0];
+        }
+    }
+
+    game->active_piece = Game_spawn_piece(game, Game_pop_kind(game));
+}
+
+void Game_move_active_piece(Game* game, Direction direction)
+{
+    switch (direction) {
+    case Left:
+        if (Game_active_piece_can_go_left(game) == true) {
+            for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+                game->active_piece.squares[i][1] -= 1;
+            }
+        }
+        break;
+    case Right:
+        if (Game_active_piece_can_go_right(game) == true) {
+            for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+                game->active_piece.squares[i][1] += 1;
+            }
+        }
+        break;
+    }
+}
+
+bool Game_rotate_active_piece(Game* game, Direction direction)
+{
+    switch (direction) {
+    case Left:
+        return Piece_rotate(&game->active_piece, -1.0f, game);
+    case Right:
+        return Piece_rotate(&game->active_piece, 1.0f, game);
+    }
+
+    return false;
+}
+
+PieceKind Randomizer_next(Randomizer randomizer, Rng* rng, PieceKind bag[Empty], int* bag_size, PieceKind previous)
+{
+    switch (randomizer) {
+    case Uniform:
+        break;
+    case Bag: {
+        if (*bag_size == 0) {
+            for (int kind = 0; kind < Empty; ++kind) {
+                bag[kind] = (PieceKind)kind;
+            }
+            *bag_size = Empty;
+        }
+        int index = (int)(Rng_next(rng) % (uint64_t)*bag_size);
+        PieceKind kind = bag[index];
+        bag[index] = bag[*bag_size - 1];
+        *bag_size -= 1;
+        bag[*bag_size] = Empty;
+        return kind;
+    }
+    case Nes: {
+        // 8 outcomes: the 8th and a repeat of the previous kind roll again (only once)
+        int roll = (int)(Rng_next(rng) % (Empty + 1));
+        if (roll != Empty && roll != (int)previous) {
+            return (PieceKind)roll;
+        }
+        break;
+    }
+    }
+
+    return PieceKind_get_random(rng);
+}
+
+PieceKind Game_random_kind(Game* game, PieceKind previous)
+{
+    return Randomizer_next(game->randomizer, &game->rng, game->bag, &game->bag_size, previous);
+}
+
+void Game_fill_queue(Game* game)
+{
+    PieceKind previous = game->queue_count > 0 ? Game_next_kind(game, game->queue_count - 1) : Empty;
+    while (game->queue_count < QUEUE_CAPACITY) {
+        previous = Game_random_kind(game, previous);
+        game->queue[(game->queue_head + game->queue_count) % QUEUE_CAPACITY] = previous;
+        game->queue_count += 1;
+    }
+}
+
+PieceKind Game_pop_kind(Game* game)
+{
+    PieceKind kind = game->queue[game->queue_head];
+    game->queue[game->queue_head] = Empty;
+    game->queue_head = (game->queue_head + 1) % QUEUE_CAPACITY;
+    game->queue_count -= 1;
+
+    if (game->queue_count < PREVIEW_MAX) {
+        Game_fill_queue(game);
+    }
+    return kind;
+}
+
+PieceKind Game_next_kind(const Game* game, int index)
+{
+    assert(index >= 0 && index < game->queue_count);
+    return game->queue[(game->queue_head + index) % QUEUE_CAPACITY];
+}
+
+void Game_set_preview_length(Game* game, int length)
+{
+    game->preview_length = length < 1 ? 1 : length > PREVIEW_MAX ? PREVIEW_MAX : length;
+}
+
+void Game_set_upcoming(Game* game, const PieceKind* kinds, int count)
+{
+    for (int i = 0; i < QUEUE_CAPACITY; ++i) {
+        game->queue[i] = i < count ? kinds[i] : Empty;
+    }
+    game->queue_head = 0;
+    game->queue_count = count < QUEUE_CAPACITY ? count : QUEUE_CAPACITY;
+    Game_fill_queue(game);
+}
+
+int Score_for_lines(int lines, int level)
+{
+    switch (lines) {
+    case 1:
+        return 40 * (level + 1);
+    case 2:
+        return 100 * (level + 1);
+    case 3:
+        return 300 * (level + 1);
+    case 4:
+        return 1200 * (level + 1);
+    }
+
+    return 0;
+}
+
+bool Level_is_completed(int current_level, int start_level, int destroyed_lines)
+{
+    return (current_level == start_level && A_TYPE_P(start_level, destroyed_lines)) || (current_level > start_level && (destroyed_lines >= ((start_level * 10 + 10) + (current_level - start_level) * 10)));
+}
+
+void Game_update_score(Game* game, int lines)
+{
+    game->score += Score_for_lines(lines, game->current_level);
+}
+
+int Game_delete_full_rows_if_exists(Game* game)
+{
+    return Game_is_standard(game) ? Game_delete_full_rows_if_exists_standard(game) : Game_delete_full_rows_if_exists_sized(game);
+}
+
+int Game_rows_filled_by_active_piece(const Game* game, int rows[4])
+{
+    return Game_is_standard(game) ? Game_rows_filled_by_active_piece_standard(game, rows) : Game_rows_filled_by_active_piece_sized(game, rows);
+}
+
+bool Game_check_game_over(Game* game)
+{
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        if (game->board[game->active_piece.squares[i][0]][game->active_piece.squares[i][1]].active == true) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Game_check_next_level(Game* game, int start_level)
+{
+    if (Level_is_completed(game->current_level, start_level, game->destroyed_lines)) {
+        game->current_level += 1;
+        return true;
+    }
+
+    return false;
+}
+
+int Game_lock_active_piece(Game* game, int start_level, bool* next_level)
+{
+    Game_release_active_piece(game);
+    int deleted_rows = Game_delete_full_rows_if_exists(game);
+    Game_update_score(game, deleted_rows);
+
+    bool changed = Game_check_next_level(game, start_level);
+    if (next_level != nullptr) {
+        *next_level = changed;
+    }
+
+    return deleted_rows;
+}
+
+bool Game_place_active_piece(Game* game, int rotation, int column)
+{
+    for (int i = 0; i < rotation; ++i) {
+        if (!Game_rotate_active_piece(game, Right)) {
+            return false;
+        }
+    }
+
+    while (Piece_left_square(&game->active_piece) != column) {
+        Direction direction = Piece_left_square(&game->active_piece) > column ? Left : Right;
+        if ((direction == Left && !Game_active_piece_can_go_left(game)) || (direction == Right && !Game_active_piece_can_go_right(game))) {
+            return false;
+        }
+        Game_move_active_piece(game, direction);
+    }
+
+    Game_hard_drop_active_piece(game);
+
+    return true;
+}
+
+uint64_t Zobrist_cell(int row, int col)
+{
+    uint64_t z = (uint64_t)(row * COLS + col + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t Zobrist_piece(PieceKind kind)
+{
+    return Zobrist_cell(TOTAL_ROWS + (int)kind, 0);
+}
+
+uint64_t Game_compute_hash(const Game* game)
+{
+    return Game_is_standard(game) ? Game_compute_hash_standard(game) : Game_compute_hash_sized(game);
+}
+
+uint64_t Game_position_hash(const Game* game)
+{
+    return game->hash ^ Zobrist_piece(game->active_piece.kind);
+}
+
+uint64_t TTData_pack(TTData data)
+{
+    return (uint64_t)data.depth
+        | (uint64_t)data.move << 8
+        | (uint64_t)data.generation << 16;
+}
+
+TTData TTData_unpack(uint64_t packed)
+{
+    return (TTData) {
+        .depth = (uint8_t)packed,
+        .move = (uint8_t)(packed >> 8),
+        .generation = (uint32_t)(packed >> 16),
+    };
+}
+
+bool TranspositionTable_init(TranspositionTable* table, int log2_entries)
+{
+    assert(log2_entries > 0 && log2_entries < 40);
+    size_t count = (size_t)1 << log2_entries;
+
+    table->entries = calloc(count, sizeof(TTEntry));
+    if (table->entries == nullptr) {
+        return false;
+    }
+    table->mask = count - 1;
+    table->generation = 0;
+    return true;
+}
+
+void TranspositionTable_free(TranspositionTable* table)
+{
+    free(table->entries);
+    table->entries = nullptr;
+    table->mask = 0;
+}
+
+void TranspositionTable_new_generation(TranspositionTable* table)
+{
+    table->generation += 1;
+}
+
+bool TranspositionTable_probe(const TranspositionTable* table, uint64_t key, TTData* data)
+{
+    TTEntry* entry = &table->entries[key & table->mask];
+    uint64_t packed = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    uint64_t value = atomic_load_explicit(&entry->value, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&entry->key_xor_data, memory_order_relaxed);
+
+    if ((check ^ packed ^ value) != key) {
+        return false;
+    }
+    TTData found = TTData_unpack(packed);
+    // An older search saw other pieces after this position
+    if (found.generation != table->generation) {
+        return false;
+    }
+    memcpy(&found.value, &value, sizeof(value));
+    *data = found;
+    return true;
+}
+
+void TranspositionTable_store(TranspositionTable* table, uint64_t key, TTData data)
+{
+    TTEntry* entry = &table->entries[key & table->mask];
+    uint64_t old_packed = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    uint64_t old_value = atomic_load_explicit(&entry->value, memory_order_relaxed);
+    uint64_t old_key = atomic_load_explicit(&entry->key_xor_data, memory_order_relaxed) ^ old_packed ^ old_value;
+    TTData old = TTData_unpack(old_packed);
+
+    if (old_key != key && old.generation == table->generation && old.depth > data.depth) {
+        return;
+    }
+
+    data.generation = table->generation;
+    uint64_t packed = TTData_pack(data);
+    uint64_t value = 0;
+    memcpy(&value, &data.value, sizeof(value));
+    atomic_store_explicit(&entry->data, packed, memory_order_relaxed);
+    atomic_store_explicit(&entry->value, value, memory_order_relaxed);
+    atomic_store_explicit(&entry->key_xor_data, key ^ packed ^ value, memory_order_relaxed);
+}
+
+void BitStream_write(BitStream* stream, uint64_t value, int bits)
+{
+    for (int i = 0; i < bits; ++i) {
+        assert(stream->bit < stream->capacity * 8);
+        if ((value >> i) & 1) {
+            stream->bytes[stream->bit >> 3] |= (uint8_t)(1u << (stream->bit & 7));
+        }
+        stream->bit += 1;
+    }
+}
+
+uint64_t BitStream_read(BitStream* stream, int bits, bool* ok)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bits; ++i) {
+        if (stream->bit >= stream->capacity * 8) {
+            *ok = false;
+            return 0;
+        }
+        value |= (uint64_t)((stream->bytes[stream->bit >> 3] >> (stream->bit & 7)) & 1) << i;
+        stream->bit += 1;
+    }
+    return value;
+}
+
+void BitStream_write_varint(BitStream* stream, uint32_t value)
+{
+    do {
+        BitStream_write(stream, value & 0x7F, 7);
+        value >>= 7;
+        BitStream_write(stream, value != 0, 1);
+    } while (value != 0);
+}
+
+uint32_t BitStream_read_varint(BitStream* stream, bool* ok)
+{
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35 && *ok; shift += 7) {
+        value |= (uint32_t)BitStream_read(stream, 7, ok) << shift;
+        if (BitStream_read(stream, 1, ok) == 0) {
+            return value;
+        }
+    }
+    *ok = false;
+    return 0;
+}
+
+void Game_snapshot(const Game* game, GameSnapshot* snapshot)
+{
+    static_assert(TOTAL_ROWS <= 32 && COLS <= 16, "Snapshot squares are packed in 5 + 4 bits");
+    assert(Game_is_standard(game));
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->bytes[0] = SNAPSHOT_VERSION;
+    BitStream stream = { .bytes = snapshot->bytes + 1, .capacity = SNAPSHOT_MAX_BYTES - 1, .bit = 0 };
+
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            BitStream_write(&stream, game->board[row][col].active, 1);
+        }
+    }
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            if (game->board[row][col].active) {
+                BitStream_write(&stream, game->board[row][col].type, 3);
+            }
+        }
+    }
+
+    BitStream_write(&stream, game->active_piece.kind, 3);
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        BitStream_write(&stream, game->active_piece.squares[i][0], 5);
+        BitStream_write(&stream, game->active_piece.squares[i][1], 4);
+    }
+    BitStream_write(&stream, game->preview_length, 3);
+    BitStream_write(&stream, game->queue_count, 5);
+    for (int i = 0; i < game->queue_count; ++i) {
+        BitStream_write(&stream, Game_next_kind(game, i), 3);
+    }
+    BitStream_write(&stream, game->rng.state, 64);
+    BitStream_write(&stream, game->randomizer, 2);
+    BitStream_write(&stream, game->bag_size, 3);
+    for (int i = 0; i < game->bag_size; ++i) {
+        BitStream_write(&stream, game->bag[i], 3);
+    }
+
+    BitStream_write_varint(&stream, (uint32_t)game->destroyed_lines);
+    BitStream_write_varint(&stream, (uint32_t)game->score);
+    BitStream_write_varint(&stream, (uint32_t)game->best_score);
+    BitStream_write_varint(&stream, (uint32_t)game->current_level);
+
+    snapshot->size = (uint8_t)(1 + (stream.bit + 7) / 8);
+}
+
+bool Game_restore(Game* game, const GameSnapshot* snapshot)
+{
+    if (snapshot->size < 1 || snapshot->size > SNAPSHOT_MAX_BYTES || snapshot->bytes[0] != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    bool ok = true;
+    BitStream stream = { .bytes = (uint8_t*)snapshot->bytes + 1, .capacity = snapshot->size - 1, .bit = 0 };
+    Game restored = { .rows = ROWS, .cols = COLS };
+
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            restored.board[row][col].active = BitStream_read(&stream, 1, &ok) == 1;
+            restored.board[row][col].type = Empty;
+        }
+    }
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            if (restored.board[row][col].active) {
+                restored.board[row][col].type = (PieceKind)BitStream_read(&stream, 3, &ok);
+                ok = ok && restored.board[row][col].type < Empty;
+            }
+        }
+    }
+
+    restored.active_piece.kind = (PieceKind)BitStream_read(&stream, 3, &ok);
+    for (int i = 0; i < ARRAY_LEN_INT(restored.active_piece.squares); ++i) {
+        restored.active_piece.squares[i][0] = (int)BitStream_read(&stream, 5, &ok);
+        restored.active_piece.squares[i][1] = (int)BitStream_read(&stream, 4, &ok);
+        ok = ok && restored.active_piece.squares[i][0] < TOTAL_ROWS && restored.active_piece.squares[i][1] < COLS;
+    }
+
+    // The queued pieces never move before becoming active, so their kinds are enough
+    restored.preview_length = (int)BitStream_read(&stream, 3, &ok);
+    restored.queue_count = (int)BitStream_read(&stream, 5, &ok);
+    ok = ok && restored.preview_length >= 1 && restored.preview_length <= PREVIEW_MAX
+        && restored.queue_count >= PREVIEW_MAX && restored.queue_count <= QUEUE_CAPACITY;
+    for (int i = 0; i < QUEUE_CAPACITY; ++i) {
+        restored.queue[i] = Empty;
+    }
+    for (int i = 0; ok && i < restored.queue_count; ++i) {
+        restored.queue[i] = (PieceKind)BitStream_read(&stream, 3, &ok);
+        ok = ok && restored.queue[i] < Empty;
+    }
+    restored.rng.state = BitStream_read(&stream, 64, &ok);
+    restored.randomizer = (Randomizer)BitStream_read(&stream, 2, &ok);
+    restored.bag_size = (int)BitStream_read(&stream, 3, &ok);
+    ok = ok && restored.randomizer <= Nes && restored.bag_size < Empty;
+    for (int i = 0; i < Empty; ++i) {
+        restored.bag[i] = Empty;
+    }
+    for (int i = 0; ok && i < restored.bag_size; ++i) {
+        restored.bag[i] = (PieceKind)BitStream_read(&stream, 3, &ok);
+        ok = ok && restored.bag[i] < Empty;
+    }
+
+    restored.destroyed_lines = (int)BitStream_read_varint(&stream, &ok);
+    restored.score = (int)BitStream_read_varint(&stream, &ok);
+    restored.best_score = (int)BitStream_read_varint(&stream, &ok);
+    restored.current_level = (int)BitStream_read_varint(&stream, &ok);
+
+    if (!ok || restored.active_piece.kind >= Empty || restored.rng.state == 0) {
+        return false;
+    }
+
+    restored.hash = Game_compute_hash(&restored);
+    Game_compute_column_tops(&restored);
+    *game = restored;
+    return true;
+}
+
+uint64_t GameSnapshot_hash(const GameSnapshot* snapshot)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int i = 0; i < snapshot->size; ++i) {
+        hash ^= snapshot->bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool GameSnapshot_equal(const GameSnapshot* a, const GameSnapshot* b)
+{
+    return a->size == b->size && memcmp(a->bytes, b->bytes, a->size) == 0;
+}
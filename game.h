@@ -0,0 +1,442 @@
+#ifndef GAME_H_
+#define GAME_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define COLS 10
+#define ROWS 20
+#define HIDDEN_ROWS 2
+#define TOTAL_ROWS (ROWS + HIDDEN_ROWS)
+
+/*
+    Sizes of the variant boards (Game_init_sized). COLS x ROWS above is the standard one:
+    its board functions are compiled with the size as constants (game_board.h), the others
+    read it from the Game. Bots, snapshots and the batched games only play the standard one
+*/
+#define COLS_MIN 4
+#define COLS_MAX 20
+#define ROWS_MIN 4
+#define ROWS_MAX 40
+#define TOTAL_ROWS_MAX (ROWS_MAX + HIDDEN_ROWS)
+
+/*
+    Upcoming kinds: at most PREVIEW_MAX are shown, QUEUE_CAPACITY (power of 2) are kept
+    generated, so the randomizer runs in bulk once every few pieces instead of on every lock
+*/
+#define PREVIEW_MAX 7
+#define QUEUE_CAPACITY 16
+
+/*
+    Macro: Predicate that return true or false based by a formula that tell
+    us when can we pass to the next level (first level).
+*/
+#define A_TYPE_P(level, destr_lines) ((level * 10 + 10) <= destr_lines)
+
+#define ARRAY_LEN_INT(arr) ((int)(sizeof(arr) / sizeof((arr)[0])))
+
+/*
+    Square is an array of 2 ints, indicating the y and x (in the square coordinate)
+*/
+typedef int Square[2];
+
+/*
+    Per-game random generator (xorshift64*). Keeping it inside the Game means a Game
+    carries all of its state and can be snapshotted/restored exactly.
+*/
+typedef struct {
+    uint64_t state;
+} Rng;
+
+Rng Rng_seed(uint64_t seed);
+uint64_t Rng_next(Rng* rng);
+
+/*
+    All kinds of pieces in Tetris
+*/
+typedef enum {
+    T,
+    J,
+    Z,
+    O,
+    S,
+    L,
+    I,
+    Empty
+} PieceKind;
+
+PieceKind PieceKind_get_random(Rng* rng);
+
+/*
+    How the next piece kind is chosen:
+    - Uniform: every kind with the same probability (the original behaviour)
+    - Bag: the 7 kinds shuffled in a bag, a new bag when it is empty
+    - Nes: like the NES, roll again once if we got the same kind as the previous piece
+*/
+typedef enum {
+    Uniform,
+    Bag,
+    Nes
+} Randomizer;
+
+/*
+    Draw the next kind. bag and bag_size are only used by the Bag randomizer, previous is
+    the last generated kind (Empty if there is none)
+*/
+PieceKind Randomizer_next(Randomizer randomizer, Rng* rng, PieceKind bag[Empty], int* bag_size, PieceKind previous);
+
+/*
+    Points for deleting lines rows at once at level
+*/
+int Score_for_lines(int lines, int level);
+
+/*
+    True if with destroyed_lines the player passes current_level (A-type rules)
+*/
+bool Level_is_completed(int current_level, int start_level, int destroyed_lines);
+
+/*
+    A piece is composed by 4 square (tetromino) and a kind
+*/
+typedef struct {
+    PieceKind kind;
+    Square squares[4];
+} Piece;
+
+typedef enum {
+    Left,
+    Right
+} Direction;
+
+/*
+    A slot representing an empty or not square, saving the kind of the piece if there is any
+*/
+typedef struct {
+    bool active;
+    uint8_t type; // PieceKind, a byte keeps the largest board as small as the standard one was
+} Slot;
+
+/*
+    Board is simply a matrix of Slots, large enough for every size: a Game uses the
+    top left rows + HIDDEN_ROWS x cols
+*/
+typedef Slot Board[TOTAL_ROWS_MAX][COLS_MAX];
+
+typedef struct {
+    Board board;
+    int rows; // visible rows, ROWS on the standard board
+    int cols;
+    Piece active_piece;
+    PieceKind queue[QUEUE_CAPACITY]; // ring buffer of the upcoming kinds, unused slots are Empty
+    int queue_head;
+    int queue_count; // never below PREVIEW_MAX
+    int preview_length; // upcoming kinds shown to the player and to the bots (1 - PREVIEW_MAX)
+    int destroyed_lines;
+    int score;
+    int best_score;
+    int current_level;
+    uint64_t seed; // what Game_init got: with the inputs it replays the game (not in the snapshots)
+    Rng rng;
+    Randomizer randomizer;
+    PieceKind bag[Empty]; // kinds still in the bag, only for the Bag randomizer
+    int bag_size;
+    uint64_t hash; // Zobrist hash of the board occupancy, kept up to date by release and row deletion
+    int column_tops[COLS_MAX]; // row of the highest occupied square of every column, rows + HIDDEN_ROWS if empty
+} Game;
+
+/*
+    Entry of the transposition table: the key is stored xored with the data and the bits
+    of the value, so a torn write from another thread simply looks like a miss (no locks
+    needed)
+*/
+typedef struct {
+    _Atomic uint64_t key_xor_data;
+    _Atomic uint64_t data;
+    _Atomic uint64_t value;
+} TTEntry;
+
+/*
+    What a bot stores for an already evaluated position. The value is kept exact, so a hit
+    returns what the search would compute again
+*/
+typedef struct {
+    double value;
+    uint8_t depth;
+    uint8_t move;
+    uint32_t generation;
+} TTData;
+
+/*
+    Fixed size, lock-free, shared hash table from position hash to TTData. Only the
+    entries of the current generation are found: the value of a position depends on the
+    pieces that follow it, which the key does not contain, so every search is a
+    generation of its own
+*/
+typedef struct {
+    TTEntry* entries;
+    uint64_t mask;
+    uint32_t generation; // 32 bits do not wrap around in any real run
+} TranspositionTable;
+
+/*
+    Snapshot wire format version, bump it every time the layout below changes
+*/
+#define SNAPSHOT_VERSION 3
+
+/*
+    Worst case size of a snapshot: version byte + occupancy bits + 3 bits of kind for
+    every cell + active piece + queue + rng state + randomizer and bag + 4 counters
+    as varints. A real board is way smaller (~70 bytes), since only occupied cells store
+    their kind.
+*/
+#define SNAPSHOT_MAX_BYTES (1 + (TOTAL_ROWS * COLS * 4 + 3 + 4 * 9 + 3 + 5 + 3 * QUEUE_CAPACITY + 64 + 2 + 3 + 3 * Empty + 4 * 40 + 7) / 8)
+
+/*
+    Bit-packed, versioned copy of a Game. Layout (LSB first after the version byte):
+    - occupancy: 1 bit per cell, row major
+    - kinds: 3 bits per occupied cell, same order
+    - active piece: kind (3 bits) + 4 squares (5 bits row, 4 bits col)
+    - preview length (3 bits), queue count (5 bits) and the queued kinds from the head
+      (3 bits each), they are always in spawn position
+    - rng state (64 bits)
+    - randomizer (2 bits), bag size (3 bits) and the kinds left in the bag (3 bits each)
+    - destroyed_lines, score, best_score, current_level as varints (7 bits + continue bit)
+*/
+typedef struct {
+    uint8_t size;
+    uint8_t bytes[SNAPSHOT_MAX_BYTES];
+} GameSnapshot;
+
+/// PIECE
+
+/*
+    Return the most left square in a Piece
+*/
+int Piece_left_square(Piece* piece);
+
+/*
+    Return the most right square in a Piece
+*/
+int Piece_right_square(Piece* piece);
+
+/*
+    Rotate a piece clockwise or anti-clockwise. (direction 1 or -1)
+    Return false if the rotated piece would go out of the board or touch other squares
+*/
+bool Piece_rotate(Piece* piece, float direction, Game* game);
+
+/*
+    Return a piece of the given kind in its spawn position
+*/
+Piece Piece_spawn(PieceKind kind);
+
+/*
+    Piece_spawn on a board of cols columns: centered as on the standard one
+*/
+Piece Piece_spawn_centered(PieceKind kind, int cols);
+
+/// GAME
+
+/*
+    A game on the standard board
+*/
+Game Game_init(int level, uint64_t seed, Randomizer randomizer);
+
+/*
+    A game on a board of rows (visible) x cols, within the MIN and MAX sizes
+*/
+Game Game_init_sized(int level, uint64_t seed, Randomizer randomizer, int rows, int cols);
+
+void Game_reset(Game* game, int start_level);
+
+/*
+    True for the COLS x ROWS board, the one that runs the specialized functions
+*/
+bool Game_is_standard(const Game* game);
+
+/*
+    Piece of the given kind in its spawn position on the board of the game
+*/
+Piece Game_spawn_piece(const Game* game, PieceKind kind);
+
+/*
+    True if the Square touch any other piece on the board
+*/
+bool Game_touch_other_square(const Game* game, Square square);
+
+bool Game_active_piece_can_go_right(Game* game);
+
+bool Game_active_piece_can_go_left(Game* game);
+
+/*
+    Return true if Touched else false
+*/
+bool Game_gravity_active_piece(Game* game);
+
+/*
+    Rows the active piece can fall before touching (where its ghost is drawn). Uses the
+    column tops, so it is O(4) unless the piece is under an overhang
+*/
+int Game_drop_distance(const Game* game);
+
+/*
+    Move the active piece down until it touches (without releasing it)
+*/
+void Game_hard_drop_active_piece(Game* game);
+
+/*
+    Recompute column_tops from the board
+*/
+void Game_compute_column_tops(Game* game);
+
+/*
+    Set the current fallen piece and set as the active piece the next piece of the Game
+*/
+void Game_release_active_piece(Game* game);
+
+/*
+    Move a piece Left or Right
+*/
+void Game_move_active_piece(Game* game, Direction direction);
+
+/*
+    Utility function that wrap Piece_rotate for rotating only the active piece
+*/
+bool Game_rotate_active_piece(Game* game, Direction direction);
+
+/*
+    Draw the next kind from the game randomizer, previous is the last generated kind
+    (Empty if there is none)
+*/
+PieceKind Game_random_kind(Game* game, PieceKind previous);
+
+/*
+    Generate kinds until the queue is full
+*/
+void Game_fill_queue(Game* game);
+
+/*
+    Take the first upcoming kind out of the queue, refilling it in bulk when it gets short
+*/
+PieceKind Game_pop_kind(Game* game);
+
+/*
+    Upcoming kind index (0 is the next piece), index < queue_count
+*/
+PieceKind Game_next_kind(const Game* game, int index);
+
+void Game_set_preview_length(Game* game, int length);
+
+/*
+    Replace the queue with kinds[count] followed by new kinds (for bots, that only know the
+    preview of the game they mirror)
+*/
+void Game_set_upcoming(Game* game, const PieceKind* kinds, int count);
+
+void Game_update_score(Game* game, int lines);
+int Game_delete_full_rows_if_exists(Game* game);
+
+/*
+    Rows that are full once the active piece is released, top to bottom, without changing
+    the game. Return how many
+*/
+int Game_rows_filled_by_active_piece(const Game* game, int rows[4]);
+bool Game_check_game_over(Game* game);
+
+/*
+    Increase the level if the destroyed lines are enough (A-type rules). Return true if
+    the level changed
+*/
+bool Game_check_next_level(Game* game, int start_level);
+
+/*
+    Everything that happens when the active piece touches the ground: release it, delete
+    the full rows, update score and level. Return the number of deleted rows, next_level
+    (if not nullptr) tells if the level changed
+*/
+int Game_lock_active_piece(Game* game, int start_level, bool* next_level);
+
+/*
+    Rotate the active piece clockwise rotation times, move it until its left square is
+    on column and drop it until it touches (without releasing it).
+    Return false if the piece is blocked before reaching the placement
+*/
+bool Game_place_active_piece(Game* game, int rotation, int column);
+
+/// ZOBRIST
+
+/*
+    Random key of an occupied cell. It is a pure function of the position (splitmix64),
+    so there is no table to initialize and every thread/process agree on the keys. They
+    are unique on the standard board, the one of the bots
+*/
+uint64_t Zobrist_cell(int row, int col);
+
+/*
+    Random key of a piece kind, used to tell apart the same board with another piece to place
+*/
+uint64_t Zobrist_piece(PieceKind kind);
+
+/*
+    Hash of the board computed from scratch (game->hash is the incremental version)
+*/
+uint64_t Game_compute_hash(const Game* game);
+
+/*
+    Hash of the board plus the active piece kind: two positions with the same hash are
+    equivalent for a search, no matter the order of the placements that built them
+*/
+uint64_t Game_position_hash(const Game* game);
+
+/// TRANSPOSITION TABLE
+
+/*
+    Allocate a table of 2^log2_entries entries. Return false if the allocation fails
+*/
+bool TranspositionTable_init(TranspositionTable* table, int log2_entries);
+void TranspositionTable_free(TranspositionTable* table);
+
+/*
+    Start a new search: entries of older generations get replaced first
+*/
+void TranspositionTable_new_generation(TranspositionTable* table);
+
+/*
+    Return true and fill data if key is in the table with the current generation
+*/
+bool TranspositionTable_probe(const TranspositionTable* table, uint64_t key, TTData* data);
+
+/*
+    Store data for key, replacing the old entry if it is from an older generation or
+    it was searched less deep
+*/
+void TranspositionTable_store(TranspositionTable* table, uint64_t key, TTData data);
+
+/*
+    Depth, move and generation in one word, the value goes in a word of its own
+*/
+uint64_t TTData_pack(TTData data);
+TTData TTData_unpack(uint64_t packed);
+
+/// SNAPSHOT
+
+/*
+    Pack the whole state of the game into snapshot (standard board only)
+*/
+void Game_snapshot(const Game* game, GameSnapshot* snapshot);
+
+/*
+    Unpack snapshot into game. Return false (and leave game untouched) if the snapshot
+    has another version or it is corrupted
+*/
+bool Game_restore(Game* game, const GameSnapshot* snapshot);
+
+/*
+    FNV-1a hash of the packed bytes
+*/
+uint64_t GameSnapshot_hash(const GameSnapshot* snapshot);
+
+bool GameSnapshot_equal(const GameSnapshot* a, const GameSnapshot* b);
+
+#endif // GAME_H_
@@ -0,0 +1,220 @@
+/*
+    Board functions of game.c, compiled once for every board size they are included for.
+    Before including it define:
+    - BOARD(name): name of the function for this board
+    - BOARD_ROWS(game), BOARD_COLS(game): rows (hidden rows included) and columns
+    - BOARD_UNROLL_COLS: pragma before the loops over the columns of a row, or nothing
+
+    game.c includes it for the standard board, with TOTAL_ROWS and COLS as constants and the
+    loops over the columns fully unrolled by the pragma (not left to the optimizer), and
+    for any size, read from the game. The public Game_ functions pick one of the two with
+    Game_is_standard.
+
+    No include guard: it is included more than once on purpose.
+*/
+
+bool BOARD(Piece_rotate)(Piece* piece, float direction, Game* game);
+bool BOARD(Game_active_piece_can_go_right)(Game* game);
+bool BOARD(Game_gravity_active_piece)(Game* game);
+int BOARD(Game_drop_distance)(const Game* game);
+void BOARD(Game_compute_column_tops)(Game* game);
+int BOARD(Game_delete_full_rows_if_exists)(Game* game);
+int BOARD(Game_rows_filled_by_active_piece)(const Game* game, int rows[4]);
+uint64_t BOARD(Game_compute_hash)(const Game* game);
+
+bool BOARD(Piece_rotate)(Piece* piece, float direction, Game* game)
+{
+    const float degree = direction * PI / 2.0f;
+    const Square* origin = &piece->squares[1];
+
+    Square rotated_points[4] = { 0 };
+
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        const float x0 = (float)piece->squares[i][0] - (float)(*origin)[0];
+        const float y0 = (float)piece->squares[i][1] - (float)(*origin)[1];
+
+        int x1 = (int)(roundf(x0 * cosf(degree) - y0 * sinf(degree)));
+        int y1 = (int)(roundf(x0 * sinf(degree) + y0 * cosf(degree)));
+        x1 += (float)(*origin)[0];
+        y1 += (float)(*origin)[1];
+
+        Square points = { x1, y1 };
+        memcpy(rotated_points[i], points, sizeof(points));
+
+        if (x1 < 0 || x1 >= BOARD_ROWS(game) || y1 < 0 || y1 >= BOARD_COLS(game) || Game_touch_other_square(game, points)) {
+            return false;
+        }
+    }
+
+    memcpy(piece->squares, rotated_points, sizeof(rotated_points));
+    return true;
+}
+
+bool BOARD(Game_active_piece_can_go_right)(Game* game)
+{
+    int active_right = Piece_right_square(&game->active_piece);
+    if (active_right == BOARD_COLS(game) - 1) {
+        return false;
+    }
+
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        Square next = { game->active_piece.squares[i][0], game->active_piece.squares[i][1] + 1 };
+        if (Game_touch_other_square(game, next)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BOARD(Game_gravity_active_piece)(Game* game)
+{
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        Square next = { game->active_piece.squares[i][0] + 1, game->active_piece.squares[i][1] };
+        if (next[0] == BOARD_ROWS(game)) {
+            return true;
+        }
+
+        if (Game_touch_other_square(game, next)) {
+            return true;
+        }
+    }
+
+    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+        game->active_piece.squares[i][0] += 1;
+    }
+
+    return false;
+}
+
+int BOARD(Game_drop_distance)(const Game* game)
+{
+    const Piece* piece = &game->active_piece;
+    int distance = BOARD_ROWS(game);
+
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        int row = piece->squares[i][0];
+        int top = game->column_tops[piece->squares[i][1]];
+        if (row >= top) {
+            // Under an overhang: the column top says nothing, step down
+            distance = -1;
+            break;
+        }
+        if (top - 1 - row < distance) {
+            distance = top - 1 - row;
+        }
+    }
+    if (distance >= 0) {
+        return distance;
+    }
+
+    for (distance = 0;; ++distance) {
+        for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+            int next_row = piece->squares[i][0] + distance + 1;
+            if (next_row == BOARD_ROWS(game) || game->board[next_row][piece->squares[i][1]].active) {
+                return distance;
+            }
+        }
+    }
+}
+
+void BOARD(Game_compute_column_tops)(Game* game)
+{
+    for (int col = 0; col < BOARD_COLS(game); ++col) {
+        game->column_tops[col] = BOARD_ROWS(game);
+        for (int row = 0; row < BOARD_ROWS(game); ++row) {
+            if (game->board[row][col].active) {
+                game->column_tops[col] = row;
+                break;
+            }
+        }
+    }
+}
+
+int BOARD(Game_delete_full_rows_if_exists)(Game* game)
+{
+    int deleted_rows = 0;
+
+    for (int row = 0; row < BOARD_ROWS(game); ++row) {
+        bool full_row = true;
+
+        // Check if the row is full
+        BOARD_UNROLL_COLS
+        for (int col = 0; col < BOARD_COLS(game); ++col) {
+            if (game->board[row][col].active == false) {
+                full_row = false;
+                break;
+            }
+        }
+
+        // Delete the row
+        if (full_row == true) {
+            deleted_rows += 1;
+
+            int row_start = row;
+
+            while (row_start > 0) {
+                BOARD_UNROLL_COLS
+                for (int col = 0; col < BOARD_COLS(game); ++col) {
+                    // Remove the old cell from the hash and add the one coming from above
+                    if (game->board[row_start][col].active != game->board[row_start - 1][col].active) {
+                        game->hash ^= Zobrist_cell(row_start, col);
+                    }
+                    memcpy(&game->board[row_start][col], &game->board[row_start - 1][col], sizeof(Slot));
+                }
+                row_start -= 1;
+            }
+        }
+    }
+    // Rare enough (only after a clear) to recompute instead of tracking the shifts
+    if (deleted_rows > 0) {
+        BOARD(Game_compute_column_tops)(game);
+    }
+    game->destroyed_lines += deleted_rows;
+    return deleted_rows;
+}
+
+int BOARD(Game_rows_filled_by_active_piece)(const Game* game, int rows[4])
+{
+    int count = 0;
+
+    for (int row = 0; row < BOARD_ROWS(game); ++row) {
+        int filled = 0;
+        bool touched = false;
+        BOARD_UNROLL_COLS
+        for (int col = 0; col < BOARD_COLS(game); ++col) {
+            filled += game->board[row][col].active ? 1 : 0;
+        }
+        for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+            if (game->active_piece.squares[i][0] == row) {
+                filled += 1;
+                touched = true;
+            }
+        }
+
+        if (touched && filled == BOARD_COLS(game)) {
+            rows[count++] = row;
+        }
+    }
+
+    return count;
+}
+
+uint64_t BOARD(Game_compute_hash)(const Game* game)
+{
+    uint64_t hash = 0;
+    for (int row = 0; row < BOARD_ROWS(game); ++row) {
+        BOARD_UNROLL_COLS
+        for (int col = 0; col < BOARD_COLS(game); ++col) {
+            if (game->board[row][col].active) {
+                hash ^= Zobrist_cell(row, col);
+            }
+        }
+    }
+    return hash;
+}
+
+#undef BOARD
+#undef BOARD_ROWS
+#undef BOARD_COLS
+#undef BOARD_UNROLL_COLS
@@ -0,0 +1,226 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "leaderboard.h"
+
+// The file layout must not depend on the compiler
+static_assert(sizeof(LeaderboardEntry) == 40, "LeaderboardEntry is part of the file format");
+static_assert(sizeof(LeaderboardData) == 24 + LEADERBOARD_LEVELS * LEADERBOARD_TOP * sizeof(LeaderboardEntry), "LeaderboardData is the file");
+
+/*
+    An empty leaderboard with a valid header
+*/
+void LeaderboardData_empty(LeaderboardData* data);
+
+/*
+    FNV-1a of the entries
+*/
+uint64_t LeaderboardData_checksum(const LeaderboardData* data);
+
+bool LeaderboardData_valid(const LeaderboardData* data);
+
+/*
+    Map the file and copy it into data, false if it is missing or not valid
+*/
+bool LeaderboardData_load(LeaderboardData* data, const char* path);
+
+/*
+    Write data to path.tmp, sync it and rename it over path
+*/
+bool LeaderboardData_save(const LeaderboardData* data, const char* path);
+
+/*
+    Writer thread: save the pending data until the leaderboard is closed
+*/
+void* Leaderboard_writer(void* arg);
+
+void Leaderboard_open(Leaderboard* leaderboard, const char* path)
+{
+    memset(leaderboard, 0, sizeof(*leaderboard));
+    snprintf(leaderboard->path, sizeof(leaderboard->path), "%s", path);
+    if (!LeaderboardData_load(&leaderboard->data, path)) {
+        LeaderboardData_empty(&leaderboard->data);
+    }
+
+#ifndef __EMSCRIPTEN__
+    pthread_mutex_init(&leaderboard->mutex, nullptr);
+    pthread_cond_init(&leaderboard->wake, nullptr);
+    leaderboard->running = true;
+    leaderboard->threaded = pthread_create(&leaderboard->writer, nullptr, Leaderboard_writer, leaderboard) == 0;
+#endif
+}
+
+void Leaderboard_close(Leaderboard* leaderboard)
+{
+    if (!leaderboard->threaded) {
+        return;
+    }
+    pthread_mutex_lock(&leaderboard->mutex);
+    leaderboard->running = false;
+    pthread_cond_signal(&leaderboard->wake);
+    pthread_mutex_unlock(&leaderboard->mutex);
+
+    pthread_join(leaderboard->writer, nullptr);
+    pthread_cond_destroy(&leaderboard->wake);
+    pthread_mutex_destroy(&leaderboard->mutex);
+    leaderboard->threaded = false;
+}
+
+int Leaderboard_submit(Leaderboard* leaderboard, int start_level, LeaderboardEntry entry)
+{
+    if (start_level < 0 || start_level >= LEADERBOARD_LEVELS || entry.score <= 0) {
+        return -1;
+    }
+    entry.tag[LEADERBOARD_TAG_MAX - 1] = '\0';
+
+    // Ties keep the older game first
+    LeaderboardEntry* entries = leaderboard->data.entries[start_level];
+    int rank = 0;
+    while (rank < LEADERBOARD_TOP && entries[rank].score >= entry.score) {
+        rank += 1;
+    }
+    if (rank == LEADERBOARD_TOP) {
+        return -1;
+    }
+    memmove(&entries[rank + 1], &entries[rank], (size_t)(LEADERBOARD_TOP - rank - 1) * sizeof(*entries));
+    entries[rank] = entry;
+    leaderboard->data.checksum = LeaderboardData_checksum(&leaderboard->data);
+
+    if (!leaderboard->threaded) {
+        LeaderboardData_save(&leaderboard->data, leaderboard->path);
+        return rank;
+    }
+
+    // Only the last data matters, a save still pending is replaced
+    pthread_mutex_lock(&leaderboard->mutex);
+    leaderboard->pending = leaderboard->data;
+    leaderboard->has_pending = true;
+    pthread_cond_signal(&leaderboard->wake);
+    pthread_mutex_unlock(&leaderboard->mutex);
+    return rank;
+}
+
+int Leaderboard_best(const Leaderboard* leaderboard, int start_level)
+{
+    if (start_level < 0 || start_level >= LEADERBOARD_LEVELS) {
+        return 0;
+    }
+    return leaderboard->data.entries[start_level][0].score;
+}
+
+void* Leaderboard_writer(void* arg)
+{
+    Leaderboard* leaderboard = arg;
+    LeaderboardData data;
+
+    pthread_mutex_lock(&leaderboard->mutex);
+    while (true) {
+        while (leaderboard->running && !leaderboard->has_pending) {
+            pthread_cond_wait(&leaderboard->wake, &leaderboard->mutex);
+        }
+        if (!leaderboard->has_pending) {
+            break;
+        }
+        data = leaderboard->pending;
+        leaderboard->has_pending = false;
+
+        // The disk is slow, the game can submit meanwhile
+        pthread_mutex_unlock(&leaderboard->mutex);
+        if (!LeaderboardData_save(&data, leaderboard->path)) {
+            fprintf(stderr, "Cannot save the leaderboard to %s\n", leaderboard->path);
+        }
+        pthread_mutex_lock(&leaderboard->mutex);
+    }
+    pthread_mutex_unlock(&leaderboard->mutex);
+    return nullptr;
+}
+
+void LeaderboardData_empty(LeaderboardData* data)
+{
+    memset(data, 0, sizeof(*data));
+    data->magic = LEADERBOARD_MAGIC;
+    data->version = LEADERBOARD_VERSION;
+    data->levels = LEADERBOARD_LEVELS;
+    data->top = LEADERBOARD_TOP;
+    data->checksum = LeaderboardData_checksum(data);
+}
+
+uint64_t LeaderboardData_checksum(const LeaderboardData* data)
+{
+    const uint8_t* bytes = (const uint8_t*)data->entries;
+    uint64_t hash = 0xcbf29ce484222325u;
+    for (size_t i = 0; i < sizeof(data->entries); ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3u;
+    }
+    return hash;
+}
+
+bool LeaderboardData_valid(const LeaderboardData* data)
+{
+    return data->magic == LEADERBOARD_MAGIC && data->version == LEADERBOARD_VERSION && data->levels == LEADERBOARD_LEVELS
+        && data->top == LEADERBOARD_TOP && data->checksum == LeaderboardData_checksum(data);
+}
+
+bool LeaderboardData_load(LeaderboardData* data, const char* path)
+{
+#ifdef __EMSCRIPTEN__
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool read = fread(data, sizeof(*data), 1, file) == 1;
+    fclose(file);
+    return read && LeaderboardData_valid(data);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size != (off_t)sizeof(*data)) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, sizeof(*data), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    memcpy(data, map, sizeof(*data));
+    munmap(map, sizeof(*data));
+    return LeaderboardData_valid(data);
+#endif
+}
+
+bool LeaderboardData_save(const LeaderboardData* data, const char* path)
+{
+#ifdef __EMSCRIPTEN__
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(data, sizeof(*data), 1, file) == 1;
+    return fclose(file) == 0 && written;
+#else
+    char temporary[512];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+
+    FILE* file = fopen(temporary, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(data, sizeof(*data), 1, file) == 1 && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !written) {
+        remove(temporary);
+        return false;
+    }
+    return rename(temporary, path) == 0;
+#endif
+}
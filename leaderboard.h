@@ -0,0 +1,78 @@
+#ifndef LEADERBOARD_H_
+#define LEADERBOARD_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+    Local leaderboard: the best LEADERBOARD_TOP games of every start level.
+
+    The file is exactly a LeaderboardData (little endian, fixed size, no pointers), so it
+    is loaded with a single map of the file and a copy. A background thread writes every
+    change to a temporary file and renames it over the old one: a crash leaves the old or
+    the new leaderboard, never half of it. The game only hands over a copy of the data.
+
+    On the web there are no threads and the file is written in place.
+*/
+
+#define LEADERBOARD_MAGIC 0x42544543u // "CETB"
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_LEVELS 10
+#define LEADERBOARD_TOP 10
+#define LEADERBOARD_TAG_MAX 16
+#define LEADERBOARD_PATH "cetris-leaderboard.bin"
+
+typedef struct {
+    int32_t score; // 0 if the entry is empty
+    int32_t lines;
+    int64_t date; // seconds since the epoch
+    uint64_t replay_id; // seed of the game
+    char tag[LEADERBOARD_TAG_MAX]; // player, 0 terminated
+} LeaderboardEntry;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t levels;
+    uint32_t top;
+    uint64_t checksum; // FNV-1a of the entries
+    LeaderboardEntry entries[LEADERBOARD_LEVELS][LEADERBOARD_TOP]; // best first
+} LeaderboardData;
+
+typedef struct {
+    LeaderboardData data;
+    char path[256];
+
+    // Writer thread, pending is the last data to write
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    LeaderboardData pending;
+    bool has_pending;
+    bool running;
+    bool threaded;
+} Leaderboard;
+
+/*
+    Load path (an empty leaderboard if it is missing or not valid) and start the writer
+*/
+void Leaderboard_open(Leaderboard* leaderboard, const char* path);
+
+/*
+    Write what is pending and stop the writer
+*/
+void Leaderboard_close(Leaderboard* leaderboard);
+
+/*
+    Insert a finished game of start_level and save the leaderboard in the background.
+    Return its rank (0 is the best) or -1 if it is not good enough
+*/
+int Leaderboard_submit(Leaderboard* leaderboard, int start_level, LeaderboardEntry entry);
+
+/*
+    Best score of start_level, 0 if there is none
+*/
+int Leaderboard_best(const Leaderboard* leaderboard, int start_level);
+
+#endif // LEADERBOARD_H_
@@ -1,46 +1,68 @@
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include <raylib.h>
+#include <rlgl.h>
+
+#include "animation.h"
+#include "bloom.h"
+#include "bot.h"
+#include "endless.h"
+#include "eventlog.h"
+#include "leaderboard.h"
+#include "metrics.h"
+#include "particles.h"
+#include "quality.h"
+#include "screen.h"
+#include "sfx.h"
+#include "game.h"
 
 #if defined(PLATFORM_WEB)
 #include <emscripten/emscripten.h>
 #endif
 
-#ifdef PLATFORM_WEB
-#define COLS 10
-#define ROWS 20
-#define HIDDEN_ROWS 2
-#define TOTAL_ROWS (ROWS + HIDDEN_ROWS)
-#define SQUARE_SIZE 40
-#define GUI_SIZE 300
-#define LINE_THICKNESS 2.0f
-#else
-#define COLS 10
-#define ROWS 20
-#define HIDDEN_ROWS 2
-#define TOTAL_ROWS (ROWS + HIDDEN_ROWS)
+// Layout, in the pixels of the game (see screen.h)
 #define SQUARE_SIZE 50
 #define GUI_SIZE 400
 #define LINE_THICKNESS 2.0f
+
+// Starting window of the layout, also the default internal resolution (--resolution).
+// The canvas of the web page is smaller
+#ifdef PLATFORM_WEB
+#define WINDOW_SCALE 0.8f
+#else
+#define WINDOW_SCALE 1.0f
 #endif
 
+// Upcoming pieces shown by default (--preview to change it)
+#define PREVIEW_LENGTH 3
+
+// Particles: pixels per second (squared for the gravity), seconds and pixels
+#define PARTICLE_SPEED 400.0f
+#define PARTICLE_GRAVITY 900.0f
+#define PARTICLE_LIFE 1.2f
+#define PARTICLE_SIZE 3.0f
+#define PARTICLES_PER_SQUARE 96
+#define TETRIS_PARTICLES_PER_SQUARE 512
+#define LEVEL_UP_PARTICLES 4096
+// Quads per draw call, under the smallest default rlgl batch (2048 on the web)
+#define PARTICLES_DRAW_CHUNK 1024
+
+// Endless mode: how fast the view follows the piece (1 / seconds) and rows between the marks
+#define ENDLESS_CAMERA_SPEED 8.0f
+#define ENDLESS_MARK_ROWS 50
+
 /*
     Macro: define a formula to calculate the time that a piece need to go down
     by 1 square based on level.
 */
 #define LEVEL_TIME(g) powf((0.8 - (g) * 0.007), g)
 
-/*
-    Macro: Predicate that return true or false based by a formula that tell
-    us when can we pass to the next level (first level).
-*/
-#define A_TYPE_P(level, destr_lines) ((level * 10 + 10) <= destr_lines)
-
 /*
     Macro: needs to abstract some code that needs to be copy-pasted every time
 */
@@ -51,32 +73,6 @@
         return true;                  \
     } while (0)
 
-#define ARRAY_LEN_INT(arr) ((int)(sizeof(arr) / sizeof((arr)[0])))
-
-/*
-    Square is an array of 2 ints, indicating the y and x (in the square coordinate)
-*/
-typedef int Square[2];
-
-/*
-    All kinds of pieces in Tetris
-*/
-typedef enum {
-    T,
-    J,
-    Z,
-    O,
-    S,
-    L,
-    I,
-    Empty
-} PieceKind;
-
-PieceKind PieceKind_get_random(void)
-{
-    return (PieceKind)(rand() % Empty);
-}
-
 /*
     Macro: Return a color based of piece
 */
@@ -90,105 +86,106 @@ PieceKind PieceKind_get_random(void)
                                          : (assert(false), BLACK))
 
 /*
-    A piece is composed by 4 square (tetromino) and a kind
+    Draw the board and the active piece, with the board starting at starting_x, and the
+    line clears of timeline over it (timeline can be nullptr)
 */
-typedef struct {
-    PieceKind kind;
-    Square squares[4];
-} Piece;
-
-typedef enum {
-    Left,
-    Right
-} Direction;
+void Game_draw_on_window(const Game* game, const Timeline* timeline, int starting_x, const RenderQuality* quality, float delta_time);
 
 /*
-    A slot representing an empty or not square, saving the kind of the piece if there is any
+    Draw the deleted rows of a line clear where they were, shrinking under a flash
 */
-typedef struct {
-    bool active;
-    PieceKind type;
-} Slot;
+void AnimationEvent_draw_line_clear(const AnimationEvent* event, float time, int starting_x, int cols, const RenderQuality* quality);
 
 /*
-    Board is simply a matrix of Slots
+    Draw all the particles as size x size squares with a few batched draw calls, fading
+    them out in their last quarter of second
 */
-typedef Slot Board[TOTAL_ROWS][COLS];
+void ParticlePool_draw(const ParticlePool* pool, float size);
 
-typedef struct {
-    Board board;
-    Piece active_piece;
-    Piece next_piece;
-    int destroyed_lines;
-    int score;
-    int best_score;
-    int current_level;
-} Game;
-
-/// PIECE
-
-/*
-    Return the most left square in a Piece
-*/
-int Piece_left_square(Piece* piece);
-
-/*
-    Return the most right square in a Piece
-*/
-int Piece_right_square(Piece* piece);
+void play_screen_input(
+    Game* game,
+    Sound* theme,
+    float* move_timer,
+    float* move_delay,
+    float* level_timer,
+    float* level_delay,
+    bool* music_paused,
+    bool* is_soft_drop,
+    bool* game_over,
+    bool* level_selection_screen,
+    bool* paused,
+    int start_level,
+    Timeline* timeline,
+    ParticlePool* particles,
+    GameMetrics* metrics,
+    EventLog* event_log,
+    BotOpponent* opponent);
 
-/*
-    Rotate a piece clockwise or anti-clockwise. (direction 1 or -1)
-*/
-void Piece_rotate(Piece* piece, float direction, Game* game);
+void play_screen_render(
+    Game* game,
+    const RenderQuality* quality,
+    const Bloom* bloom,
+    bool* game_over,
+    bool paused,
+    float* delta_time,
+    const Screen* screen,
+    const Timeline* timeline,
+    const ParticlePool* particles,
+    const GameMetrics* metrics,
+    const BotOpponent* opponent);
 
 /*
-    Generate a random piece
+    The boards and the particles: what blooms
 */
-Piece spawn_piece(void);
+void play_screen_render_boards(
+    const Game* game,
+    const RenderQuality* quality,
+    float delta_time,
+    const Timeline* timeline,
+    const ParticlePool* particles,
+    const BotOpponent* opponent);
 
-/// GAME
-
-Game Game_init(int level);
-
-void Game_reset(Game* game, int start_level);
+void play_screen_logic(
+    Game* game,
+    Sound* theme,
+    SfxMixer* sfx,
+    int* start_level,
+    float* delta_time,
+    float* level_timer,
+    float* level_delay,
+    float* move_timer,
+    bool* is_soft_drop,
+    bool* music_paused,
+    bool* game_over,
+    Timeline* timeline,
+    ParticlePool* particles,
+    GameMetrics* metrics,
+    EventLog* event_log);
 
 /*
-    True if the Square touch any other piece on the board
+    Resume the game when P is pressed, and the music if it was not muted
 */
-bool Game_touch_other_square(const Game* game, Square square);
-
-bool Game_active_piece_can_go_right(Game* game);
-
-bool Game_active_piece_can_go_left(Game* game);
+void pause_screen_input(bool* paused, Sound* theme, bool music_paused);
 
 /*
-    Return true if Touched else false
+    Block on input and window events instead of redrawing at 60 FPS, for the screens that
+    only change on input. Not on the web, where the browser drives the frames
 */
-bool Game_gravity_active_piece(Game* game);
+void set_event_waiting(bool* waiting, bool enabled);
 
-/*
-    Set the current fallen piece and set as the active piece the next piece of the Game
-*/
-void Game_release_active_piece(Game* game);
+bool level_selection_screen_input(int* start_level, float* level_delay);
 
 /*
-    Move a piece Left or Right
+    Ask for the start level, with the best game of every level
 */
-void Game_move_active_piece(Game* game, Direction direction);
+void level_selection_screen_render(const Screen* screen, const Leaderboard* leaderboard);
 
 /*
-    Utility function that wrap Piece_rotate for rotating only the active piece
+    Endless mode (--endless): the same keys of the play screen on the tall board, the view
+    scrolls to camera (lowest row shown, fractional while it moves)
 */
-void Game_rotate_active_piece(Game* game, Direction direction);
-
-void Game_update_score(Game* game, int lines);
-int Game_delete_full_rows_if_exists(Game* game);
-bool Game_check_game_over(Game* game);
-void Game_draw_on_window(const Game* game, int starting_x, Shader shader, float delta_time);
-
-void play_screen_input(
-    Game* game,
+void endless_screen_input(
+    EndlessGame* game,
     Sound* theme,
     float* move_timer,
     float* move_delay,
@@ -196,43 +193,169 @@ void play_screen_input(
     float* level_delay,
     bool* music_paused,
     bool* is_soft_drop,
-    bool* game_over,
     bool* level_selection_screen,
+    bool* paused,
     int start_level);
 
-void play_screen_render(
-    Game* game,
-    Shader* square_shader,
-    bool* game_over,
-    float* delta_time,
-    int screen_width,
-    int screen_height);
-
-void play_screen_logic(
-    Game* game,
+void endless_screen_render(
+    const EndlessGame* game,
+    const RenderQuality* quality,
+    const Bloom* bloom,
+    bool paused,
+    float delta_time,
+    float camera,
+    const Screen* screen);
+
+void endless_screen_logic(
+    EndlessGame* game,
     Sound* theme,
-    Sound* line_clear_sound,
-    Sound* tetris_sound,
-    Sound* next_level_sound,
-    int* start_level,
+    SfxMixer* sfx,
+    int start_level,
     float* delta_time,
     float* level_timer,
     float* level_delay,
     float* move_timer,
     bool* is_soft_drop,
     bool* music_paused,
-    bool* game_over);
+    int view_rows,
+    float* camera);
 
-bool level_selection_screen_input(int* start_level, float* level_delay);
+/*
+    Draw the view_rows rows of the endless board from camera up and the active piece.
+    Only the rows in the view are visited, not the whole board
+*/
+void EndlessGame_draw_on_window(const EndlessGame* game, float camera, int view_rows, int starting_x, const RenderQuality* quality, float delta_time);
+
+/*
+    Draw a piece of the preview with its top left corner in (x, y)
+*/
+void PieceKind_draw_preview(PieceKind kind, float x, float y, float square_size, const RenderQuality* quality);
 
-void level_selection_screen_render(int screen_width, int screen_height);
+/*
+    Draw the board of the bot on the right of the player board, with its name and score
+*/
+void BotOpponent_draw_on_window(const BotOpponent* opponent, int starting_x, const RenderQuality* quality, float delta_time);
 
-int main(void)
+int main(int argc, char** argv)
 {
-    srand(time(NULL)); // SEED
+    uint64_t seed = (uint64_t)time(NULL); // SEED
+
+    // Options: ./cetris [--preview <1-7>] [--bot "<command>"] [--audio-buffer <frames>] [--metrics <file.csv>]
+    //                   [--events <file.ndjson>] [--tag <name>] [--leaderboard <file>] [--quality <full|lut|texture|flat|auto>]
+    //                   [--bloom <0-6>] [--resolution <height>] [--scale <integer|smooth>] [--board <cols>x<rows>]
+    //                   [--endless <rows>] [--garbage <rows>]
+    const char* bot_command = nullptr;
+    const char* metrics_path = nullptr;
+    const char* events_path = nullptr;
+    const char* leaderboard_path = LEADERBOARD_PATH;
+    const char* tag = getenv("USER") != nullptr ? getenv("USER") : "player";
+    int preview_length = PREVIEW_LENGTH;
+    int audio_buffer = SFX_BUFFER_FRAMES;
+    QualityTier best_quality = QUALITY_DEFAULT;
+    bool automatic_quality = true;
+    int bloom_levels = BLOOM_DEFAULT_LEVELS;
+    int internal_height = 0; // of the window
+    bool integer_scaling = false;
+    int board_cols = COLS;
+    int board_rows = ROWS;
+    int endless_rows = 0; // tall board of the endless mode, 0 for the normal game
+    int garbage_rows = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bot") == 0 && i + 1 < argc) {
+            bot_command = argv[++i];
+        } else if (strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            preview_length = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            audio_buffer = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_path = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            events_path = argv[++i];
+        } else if (strcmp(argv[i], "--tag") == 0 && i + 1 < argc) {
+            tag = argv[++i];
+        } else if (strcmp(argv[i], "--leaderboard") == 0 && i + 1 < argc) {
+            leaderboard_path = argv[++i];
+        } else if (strcmp(argv[i], "--bloom") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 0 && atoi(argv[i + 1]) <= BLOOM_LEVELS_MAX) {
+            bloom_levels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--resolution") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            internal_height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc && (strcmp(argv[i + 1], "integer") == 0 || strcmp(argv[i + 1], "smooth") == 0)) {
+            integer_scaling = strcmp(argv[++i], "integer") == 0;
+        } else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &board_cols, &board_rows) == 2
+            && board_cols >= COLS_MIN && board_cols <= COLS_MAX && board_rows >= ROWS_MIN && board_rows <= ROWS_MAX) {
+            ++i;
+        } else if (strcmp(argv[i], "--endless") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= ENDLESS_ROWS_MIN && atoi(argv[i + 1]) <= ENDLESS_ROWS_MAX) {
+            endless_rows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--garbage") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 0) {
+            garbage_rows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            // A tier is fixed, auto lets the governor choose
+            const char* name = argv[++i];
+            automatic_quality = strcmp(name, "auto") == 0;
+            best_quality = QualityCount;
+            for (int tier = 0; tier < QualityCount && !automatic_quality; ++tier) {
+                if (strcmp(name, QualityTier_name((QualityTier)tier)) == 0) {
+                    best_quality = (QualityTier)tier;
+                }
+            }
+            if (automatic_quality) {
+                best_quality = QUALITY_DEFAULT;
+            } else if (best_quality == QualityCount) {
+                fprintf(stderr, "ERROR: unknown quality %s\n", name);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--preview <1-%d>] [--bot \"<command>\"] [--audio-buffer <frames>] [--metrics <file.csv>] [--events <file.ndjson>] [--tag <name>] [--leaderboard <file>] [--quality <full|lut|texture|flat|auto>] [--bloom <0-%d>] [--resolution <height>] [--scale <integer|smooth>] [--board <%d-%d>x<%d-%d>] [--endless <%d-%d>] [--garbage <rows>]\n", argv[0], PREVIEW_MAX, BLOOM_LEVELS_MAX, COLS_MIN, COLS_MAX, ROWS_MIN, ROWS_MAX, ENDLESS_ROWS_MIN, ENDLESS_ROWS_MAX);
+            return 1;
+        }
+    }
+
+    // Optional summary of every finished game
+    FILE* metrics_file = nullptr;
+    if (metrics_path != nullptr) {
+        metrics_file = fopen(metrics_path, "a");
+        if (metrics_file == nullptr) {
+            fprintf(stderr, "ERROR: cannot open %s\n", metrics_path);
+            return 1;
+        }
+        GameMetrics_write_csv_header(metrics_file);
+    }
+
+    // Optional event log, written by its own thread
+    EventLog session_log;
+    EventLog* event_log = nullptr;
+    if (events_path != nullptr) {
+        if (!EventLog_open(&session_log, events_path)) {
+            fprintf(stderr, "ERROR: cannot log the events to %s\n", events_path);
+            return 1;
+        }
+        event_log = &session_log;
+    }
 
-    constexpr int screen_width = COLS * SQUARE_SIZE + GUI_SIZE;
-    constexpr int screen_height = ROWS * SQUARE_SIZE;
+    // Saved by its own thread, a finished game never waits for the disk
+    Leaderboard leaderboard;
+    Leaderboard_open(&leaderboard, leaderboard_path);
+
+    // Optional opponent
+    bool standard_board = board_cols == COLS && board_rows == ROWS;
+    bool endless_mode = endless_rows > 0;
+    if (bot_command != nullptr && (!standard_board || endless_mode)) {
+        fprintf(stderr, "ERROR: the bots play only the standard %dx%d board\n", COLS, ROWS);
+        return 1;
+    }
+    BotOpponent bot_opponent;
+    BotOpponent* opponent = nullptr;
+    if (bot_command != nullptr) {
+        if (!BotOpponent_init(&bot_opponent, bot_command)) {
+            fprintf(stderr, "ERROR: cannot start the bot %s\n", bot_command);
+            return 1;
+        }
+        opponent = &bot_opponent;
+    }
+
+    // The GUI needs the height of the standard board
+    const int screen_width = board_cols * SQUARE_SIZE + GUI_SIZE + (opponent != nullptr ? COLS * SQUARE_SIZE : 0);
+    const int screen_height = (board_rows > ROWS ? board_rows : ROWS) * SQUARE_SIZE;
 
     // Global Render various screen
     bool level_selection_screen = true;
@@ -249,57 +372,179 @@ int main(void)
     float level_delay = LEVEL_TIME(start_level);
     float level_timer = 0.0f;
     bool is_soft_drop = false;
+    bool paused = false;
+    Timeline timeline = { 0 }; // line clear effects, the game never waits for them
+    FinesseTable finesse;
+    FinesseTable_build(&finesse);
+    GameMetrics metrics;
+    // The finesse table knows the standard board only
+    GameMetrics_init(&metrics, standard_board ? &finesse : nullptr);
     // END Play Screen variables
 
-    InitWindow(screen_width, screen_height, "Cetris");
+    // Taller boards start in a window as tall as the standard one
+    const float window_scale = WINDOW_SCALE * (float)(ROWS * SQUARE_SIZE) / (float)screen_height;
+    const int window_width = (int)((float)screen_width * window_scale);
+    const int window_height = (int)((float)screen_height * window_scale);
+#ifndef PLATFORM_WEB
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+#endif
+    InitWindow(window_width, window_height, "Cetris");
     SetTargetFPS(60);
 
     InitAudioDevice();
 
-    Sound line_clear_sound = LoadSound("resources/music/line_clear.mp3");
-    Sound tetris_sound = LoadSound("resources/music/tetris.mp3");
-    Sound next_level_sound = LoadSound("resources/music/next_level.mp3");
+    const char* sfx_paths[SfxCount] = {
+        [SfxLineClear] = "resources/music/line_clear.mp3",
+        [SfxTetris] = "resources/music/tetris.mp3",
+        [SfxNextLevel] = "resources/music/next_level.mp3",
+    };
+    SfxMixer sfx;
+    if (!SfxMixer_init(&sfx, sfx_paths, audio_buffer)) {
+        fprintf(stderr, "WARNING: no sound effects\n");
+    }
     Sound theme = LoadSound("resources/music/b-type_theme.mp3");
 
-#ifdef PLATFORM_WEB
-    Shader square_shader = LoadShader("resources/shaders/liquid_square_vertex.glsl", "resources/shaders/liquid_square_web.glsl");
-#else
-    Shader square_shader = LoadShader(nullptr, "resources/shaders/liquid_square.glsl");
-#endif
+    ParticlePool particles;
+    if (!ParticlePool_init(&particles, PARTICLES_CAPACITY, seed)) {
+        fprintf(stderr, "ERROR: cannot allocate the particles\n");
+        return 1;
+    }
 
-    Game game = Game_init(start_level);
+    RenderQuality quality;
+    RenderQuality_init(&quality, best_quality, automatic_quality);
+    Screen screen;
+    Screen_init(&screen, screen_width, screen_height, internal_height > 0 ? internal_height : window_height, integer_scaling);
+    Bloom bloom;
+    Bloom_init(&bloom, (Rectangle) { GUI_SIZE, 0.0f, (float)(screen_width - GUI_SIZE), (float)screen_height }, screen.zoom, bloom_levels);
+
+    Game game = Game_init_sized(start_level, seed, Uniform, board_rows, board_cols);
+    Game_set_preview_length(&game, preview_length);
+    // The view of the endless board is the layout, as tall as the board of --board
+    EndlessGame endless = { 0 };
+    float endless_camera = 0.0f;
+    if (endless_mode) {
+        if (!EndlessGame_init(&endless, start_level, seed, Uniform, endless_rows, board_cols, garbage_rows)) {
+            fprintf(stderr, "ERROR: cannot allocate the endless board\n");
+            return 1;
+        }
+        Game_set_preview_length(&endless.rules, preview_length);
+    }
     float delta_time = 0.0f;
+    bool event_waiting = false;
 
     while (!WindowShouldClose()) {
         if (level_selection_screen) {
             // INPUT
             if (level_selection_screen_input(&start_level, &level_delay)) {
                 level_selection_screen = false;
-                game.current_level = start_level;
+                if (endless_mode) {
+                    endless.rules.current_level = start_level;
+                } else {
+                    game.current_level = start_level;
+                    // The leaderboard is for the standard board
+                    if (standard_board) {
+                        game.best_score = Leaderboard_best(&leaderboard, start_level);
+                    }
+                    EventLog_game_start(event_log, &game, start_level);
+                    if (opponent != nullptr) {
+                        BotOpponent_start(opponent, &game, start_level);
+                    }
+                }
+            }
+            // Static screen: idle until a key is pressed. Changed before the render, so
+            // its EndDrawing already waits (or stops waiting) for events
+            set_event_waiting(&event_waiting, level_selection_screen);
+
+            // RENDER
+            level_selection_screen_render(&screen, &leaderboard);
+        } else if (endless_mode) {
+            // INPUT: no metrics, events or leaderboard, they are about the standard game
+            if (paused) {
+                pause_screen_input(&paused, &theme, music_paused);
+            } else {
+                endless_screen_input(&endless, &theme, &move_timer, &move_delay, &level_timer, &level_delay, &music_paused, &is_soft_drop, &level_selection_screen, &paused, start_level);
             }
+            set_event_waiting(&event_waiting, paused || level_selection_screen || endless.game_over);
 
             // RENDER
-            level_selection_screen_render(screen_width, screen_height);
+            endless_screen_render(&endless, &quality, &bloom, paused, delta_time, endless_camera, &screen);
+            if (!event_waiting) {
+                RenderQuality_update(&quality, GetFrameTime());
+            }
+
+            // LOGIC
+            if (!paused && !endless.game_over) {
+                endless_screen_logic(&endless, &theme, &sfx, start_level, &delta_time, &level_timer, &level_delay, &move_timer, &is_soft_drop, &music_paused, screen.height / SQUARE_SIZE, &endless_camera);
+            }
+        } else if (paused) {
+            // INPUT
+            pause_screen_input(&paused, &theme, music_paused);
+            set_event_waiting(&event_waiting, paused);
+
+            // RENDER
+            play_screen_render(&game, &quality, &bloom, &game_over, paused, &delta_time, &screen, &timeline, &particles, &metrics, opponent);
         } else {
             // INPUT
-            play_screen_input(&game, &theme, &move_timer, &move_delay, &level_timer, &level_delay, &music_paused, &is_soft_drop, &game_over, &level_selection_screen, start_level);
+            play_screen_input(&game, &theme, &move_timer, &move_delay, &level_timer, &level_delay, &music_paused, &is_soft_drop, &game_over, &level_selection_screen, &paused, start_level, &timeline, &particles, &metrics, event_log, opponent);
+            // The game over screen is static too, once the effects are over
+            set_event_waiting(&event_waiting, paused || level_selection_screen || (game_over && timeline.count == 0 && particles.count == 0));
 
             // RENDER
-            play_screen_render(&game, &square_shader, &game_over, &delta_time, screen_width, screen_height);
+            play_screen_render(&game, &quality, &bloom, &game_over, paused, &delta_time, &screen, &timeline, &particles, &metrics, opponent);
+            // The frames waiting for events are not rendering frames
+            if (!event_waiting) {
+                RenderQuality_update(&quality, GetFrameTime());
+            }
 
-            // LOGIC
+            // LOGIC: nothing moves while paused, not even the timers
+            if (paused) {
+                continue;
+            }
             if (!game_over) {
-                play_screen_logic(&game, &theme, &line_clear_sound, &tetris_sound, &next_level_sound, &start_level, &delta_time, &level_timer, &level_delay, &move_timer, &is_soft_drop, &music_paused, &game_over);
+                play_screen_logic(&game, &theme, &sfx, &start_level, &delta_time, &level_timer, &level_delay, &move_timer, &is_soft_drop, &music_paused, &game_over, &timeline, &particles, &metrics, event_log);
+                if (game_over && metrics_file != nullptr) {
+                    GameMetrics_write_csv_row(metrics_file, &metrics, &game, start_level);
+                }
+                if (game_over && standard_board) {
+                    LeaderboardEntry entry = {
+                        .score = game.score,
+                        .lines = game.destroyed_lines,
+                        .date = (int64_t)time(NULL),
+                        .replay_id = game.seed,
+                    };
+                    snprintf(entry.tag, sizeof(entry.tag), "%s", tag);
+                    Leaderboard_submit(&leaderboard, start_level, entry);
+                }
+                if (opponent != nullptr) {
+                    BotOpponent_update(opponent, GetFrameTime(), LEVEL_TIME(opponent->display.current_level));
+                }
             }
+            // Effects finish on their own time, also after the game is over
+            Timeline_advance(&timeline, GetFrameTime());
+            ParticlePool_update(&particles, GetFrameTime(), PARTICLE_GRAVITY);
         }
     }
 
     // Frees
-    UnloadShader(square_shader);
+    if (opponent != nullptr) {
+        BotOpponent_free(opponent);
+    }
+    if (metrics_file != nullptr) {
+        fclose(metrics_file);
+    }
+    if (event_log != nullptr) {
+        EventLog_close(event_log);
+    }
+    Leaderboard_close(&leaderboard);
+    ParticlePool_free(&particles);
+    if (endless_mode) {
+        EndlessGame_free(&endless);
+    }
+    RenderQuality_free(&quality);
+    Bloom_free(&bloom);
+    Screen_free(&screen);
     UnloadSound(theme);
-    UnloadSound(next_level_sound);
-    UnloadSound(tetris_sound);
-    UnloadSound(line_clear_sound);
+    SfxMixer_free(&sfx);
     CloseAudioDevice();
     CloseWindow();
 
@@ -339,16 +584,54 @@ bool level_selection_screen_input(int* start_level, float* level_delay)
     return false;
 }
 
-void level_selection_screen_render(int screen_width, int screen_height)
+void level_selection_screen_render(const Screen* screen, const Leaderboard* leaderboard)
 {
+    const int screen_width = screen->width;
+    const int screen_height = screen->height;
     BeginDrawing();
+    Screen_begin(screen);
     ClearBackground((Color) { 0x1E, 0x20, 0x1E, 0xFF });
 
     DrawText("Select a level 0-9", ((float)screen_width / 2.0) - 110, ((float)screen_height / 2.0) - 25, 25, RAYWHITE);
 
+    // Best game of every start level
+    char line[64];
+    for (int level = 0; level < LEADERBOARD_LEVELS; ++level) {
+        const LeaderboardEntry* best = &leaderboard->data.entries[level][0];
+        if (best->score == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%d  %8d  %s", level, best->score, best->tag);
+        DrawText(line, ((float)screen_width / 2.0) - 110, ((float)screen_height / 2.0) + 25 + level * 22, 20, GRAY);
+    }
+
+    Screen_end(screen);
+    Screen_draw(screen);
     EndDrawing();
 }
 
+void pause_screen_input(bool* paused, Sound* theme, bool music_paused)
+{
+    if (IsKeyPressed(KEY_P)) {
+        *paused = false;
+        if (!music_paused) {
+            ResumeSound(*theme);
+        }
+    }
+}
+
+void set_event_waiting(bool* waiting, bool enabled)
+{
+#ifndef PLATFORM_WEB
+    if (enabled && !*waiting) {
+        EnableEventWaiting();
+    } else if (!enabled && *waiting) {
+        DisableEventWaiting();
+    }
+#endif
+    *waiting = enabled;
+}
+
 void play_screen_input(
     Game* game,
     Sound* theme,
@@ -360,27 +643,69 @@ void play_screen_input(
     bool* is_soft_drop,
     bool* game_over,
     bool* level_selection_screen,
-    int start_level)
+    bool* paused,
+    int start_level,
+    Timeline* timeline,
+    ParticlePool* particles,
+    GameMetrics* metrics,
+    EventLog* event_log,
+    BotOpponent* opponent)
 {
+    // METRICS: a held move key is one press and many actions
+    if (IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_LEFT)) {
+        GameMetrics_press(metrics, InputMove);
+    }
+    if (IsKeyPressed(KEY_DOWN)) {
+        GameMetrics_press(metrics, InputSoftDrop);
+        GameMetrics_action(metrics);
+    }
+
     // Hold down a key for continuous moving
     if (IsKeyDown(KEY_RIGHT) && *move_timer >= *move_delay) {
         Game_move_active_piece(game, Right);
+        GameMetrics_action(metrics);
         *move_timer = 0.0f;
     }
     if (IsKeyDown(KEY_LEFT) && *move_timer >= *move_delay) {
         Game_move_active_piece(game, Left);
+        GameMetrics_action(metrics);
         *move_timer = 0.0f;
     }
 
     if (IsKeyPressed(KEY_Z)) {
         Game_rotate_active_piece(game, Left);
+        GameMetrics_press(metrics, InputRotate);
+        GameMetrics_action(metrics);
     }
     if (IsKeyPressed(KEY_X)) {
         Game_rotate_active_piece(game, Right);
+        GameMetrics_press(metrics, InputRotate);
+        GameMetrics_action(metrics);
+    }
+    // Hard drop, the logic locks the piece in the same frame
+    if (IsKeyPressed(KEY_SPACE)) {
+        Game_hard_drop_active_piece(game);
+        GameMetrics_press(metrics, InputHardDrop);
+        GameMetrics_action(metrics);
+        *level_timer = *level_delay;
     }
     if (IsKeyPressed(KEY_L)) {
         *level_selection_screen = true;
         Game_reset(game, start_level);
+        Timeline_clear(timeline);
+        ParticlePool_clear(particles);
+        GameMetrics_reset(metrics);
+    }
+    // Pause with P, or when the player leaves the window. On the web the browser already
+    // stops the frames of a hidden tab
+    bool left_window = false;
+#ifndef PLATFORM_WEB
+    left_window = !IsWindowFocused();
+#endif
+    if ((IsKeyPressed(KEY_P) || left_window) && !*game_over) {
+        *paused = true;
+        PauseSound(*theme);
+        return;
     }
     if (IsKeyPressed(KEY_M)) {
         if (IsSoundPlaying(*theme)) {
@@ -404,24 +729,57 @@ void play_screen_input(
     }
     if (IsKeyPressed(KEY_R)) {
         Game_reset(game, start_level);
+        Timeline_clear(timeline);
+        ParticlePool_clear(particles);
+        GameMetrics_reset(metrics);
+        EventLog_game_start(event_log, game, start_level);
         *game_over = false;
+        if (opponent != nullptr) {
+            BotOpponent_start(opponent, game, start_level);
+        }
     }
 }
 
 void play_screen_render(
     Game* game,
-    Shader* square_shader,
+    const RenderQuality* quality,
+    const Bloom* bloom,
     bool* game_over,
+    bool paused,
     float* delta_time,
-    int screen_width,
-    int screen_height)
+    const Screen* screen,
+    const Timeline* timeline,
+    const ParticlePool* particles,
+    const GameMetrics* metrics,
+    const BotOpponent* opponent)
 {
-    if (*game_over == false) {
-        BeginDrawing();
-        ClearBackground((Color) { 0x1E, 0x20, 0x1E, 0xFF });
+    const int screen_width = screen->width;
+    const int screen_height = screen->height;
+    const Color background = { 0x1E, 0x20, 0x1E, 0xFF };
+    BeginDrawing();
+
+    // The boards bloom in render textures of their own, the GUI does not
+    bool bloom_enabled = bloom->level_count > 0;
+    if (bloom_enabled) {
+        Bloom_begin(bloom, background);
+        play_screen_render_boards(game, quality, *delta_time, timeline, particles, opponent);
+        Bloom_end(bloom);
+    }
 
-        Game_draw_on_window(game, GUI_SIZE, *square_shader, *delta_time);
+    Screen_begin(screen);
+    if (*game_over == false) {
+        ClearBackground(background);
+    } else {
+        // The GUI of the last frame stays in the render texture, the boards still move
+        DrawRectangle(GUI_SIZE, 0, screen_width - GUI_SIZE, screen_height, background);
+    }
+    if (bloom_enabled) {
+        Bloom_draw(bloom);
+    } else {
+        play_screen_render_boards(game, quality, *delta_time, timeline, particles, opponent);
+    }
 
+    if (*game_over == false) {
         // GUI DRAWING
         {
             DrawRectangleLinesEx((Rectangle) { 0, 0, GUI_SIZE, screen_height }, 15, (Color) { 0x3C, 0x3D, 0x37, 0xFF });
@@ -450,50 +808,85 @@ void play_screen_render(
             sprintf(level_as_str, "%d", game->current_level);
             DrawText(level_as_str, 100, 201, 25, SKYBLUE);
 
+            // Metrics
+            char metrics_as_str[2][50] = { 0 };
+            sprintf(metrics_as_str[0], "PPS %.2f  KPP %.2f", GameMetrics_pps(metrics), GameMetrics_kpp(metrics));
+            sprintf(metrics_as_str[1], "APM %.0f  Finesse %d", GameMetrics_apm(metrics), metrics->finesse_faults);
+            DrawText(metrics_as_str[0], 25, 260, 20, LIGHTGRAY);
+            DrawText(metrics_as_str[1], 25, 290, 20, LIGHTGRAY);
+            DrawText(TextFormat("Shader %s%s", QualityTier_name(quality->tier), quality->automatic ? " (auto)" : ""), 25, 320, 20, GRAY);
+
             // Next Piece text and new piece
             DrawText("Next Piece", GUI_SIZE / 2 - 75, 420, 25, LIGHTGRAY);
-            Color next_piece_color = ColorFromPiece(game->next_piece.kind);
+            Piece next_piece = Piece_spawn(Game_next_kind(game, 0));
+            Color next_piece_color = ColorFromPiece(next_piece.kind);
 
-            for (int i = 0; i < ARRAY_LEN_INT(game->next_piece.squares); ++i) {
+            for (int i = 0; i < ARRAY_LEN_INT(next_piece.squares); ++i) {
                 float new_x = 0.0f;
-                if (game->next_piece.kind == I) {
-                    new_x = (float)(game->next_piece.squares[i][1] * SQUARE_SIZE - 85);
-                } else if (game->next_piece.kind == O) {
-                    new_x = (float)(game->next_piece.squares[i][1] * SQUARE_SIZE - 50);
+                if (next_piece.kind == I) {
+                    new_x = (float)(next_piece.squares[i][1] * SQUARE_SIZE - 85);
+                } else if (next_piece.kind == O) {
+                    new_x = (float)(next_piece.squares[i][1] * SQUARE_SIZE - 50);
                 } else {
-                    new_x = (float)(game->next_piece.squares[i][1] * SQUARE_SIZE - 70);
+                    new_x = (float)(next_piece.squares[i][1] * SQUARE_SIZE - 70);
                 }
 
                 Rectangle rect = {
                     .x = new_x - 14.0,
-                    .y = (float)(game->next_piece.squares[i][0] * SQUARE_SIZE + 510),
+                    .y = (float)(next_piece.squares[i][0] * SQUARE_SIZE + 510),
                     .width = (float)SQUARE_SIZE,
                     .height = (float)SQUARE_SIZE
                 };
 
-                BeginShaderMode(*square_shader);
+                RenderQuality_begin(quality);
                 DrawRectangleRec(rect, next_piece_color);
                 DrawRectangleLinesEx(rect, LINE_THICKNESS, BLACK);
                 EndShaderMode();
             }
+
+            // The rest of the preview, smaller and 3 per line under the next piece
+            const float small_size = SQUARE_SIZE * 0.4f;
+            for (int i = 1; i < game->preview_length; ++i) {
+                float x = 25.0f + (float)((i - 1) % 3) * (GUI_SIZE - 50) / 3.0f;
+                float y = (float)(4 * SQUARE_SIZE + 530) + (float)((i - 1) / 3) * 3.0f * small_size;
+                PieceKind_draw_preview(Game_next_kind(game, i), x, y, small_size, quality);
+            }
+        }
+
+        if (paused) {
+            DrawRectangle(GUI_SIZE, 0, screen_width - GUI_SIZE, screen_height, Fade(BLACK, 0.6f));
+            DrawText("Paused", GUI_SIZE + 25, screen_height / 3, 30, RAYWHITE);
+            DrawText("Press P to continue", GUI_SIZE + 25, screen_height / 3 + 40, 25, LIGHTGRAY);
         }
-        EndDrawing();
     } else {
-        BeginDrawing();
-        Game_draw_on_window(game, GUI_SIZE, *square_shader, *delta_time);
         DrawText("Si pers fra :(", screen_width / 4, screen_height / 3, 30, DARKBLUE);
         DrawText("Schiaccj lu tast R per continua'", screen_width / 4, screen_height / 3 + 40, 25, LIME);
-        EndDrawing();
-        return;
     }
+
+    Screen_end(screen);
+    Screen_draw(screen);
+    EndDrawing();
+}
+
+void play_screen_render_boards(
+    const Game* game,
+    const RenderQuality* quality,
+    float delta_time,
+    const Timeline* timeline,
+    const ParticlePool* particles,
+    const BotOpponent* opponent)
+{
+    Game_draw_on_window(game, timeline, GUI_SIZE, quality, delta_time);
+    if (opponent != nullptr) {
+        BotOpponent_draw_on_window(opponent, GUI_SIZE + game->cols * SQUARE_SIZE, quality, delta_time);
+    }
+    ParticlePool_draw(particles, PARTICLE_SIZE);
 }
 
 void play_screen_logic(
     Game* game,
     Sound* theme,
-    Sound* line_clear_sound,
-    Sound* tetris_sound,
-    Sound* next_level_sound,
+    SfxMixer* sfx,
     int* start_level,
     float* delta_time,
     float* level_timer,
@@ -501,7 +894,11 @@ void play_screen_logic(
     float* move_timer,
     bool* is_soft_drop,
     bool* music_paused,
-    bool* game_over)
+    bool* game_over,
+    Timeline* timeline,
+    ParticlePool* particles,
+    GameMetrics* metrics,
+    EventLog* event_log)
 {
     // Every level_decay time the game gravity by 1 slot and check if active_piece touch other squares.
     // If yes release it, delete full row if exists, sounds, update score, check if next level
@@ -509,27 +906,59 @@ void play_screen_logic(
     if (*level_timer >= *level_delay) {
         *level_timer = 0.0f;
         if (Game_gravity_active_piece(game) == true) {
-            Game_release_active_piece(game);
-            int deleted_rows = Game_delete_full_rows_if_exists(game);
+            bool next_level = false;
+            // The rows are deleted now, the timeline only remembers them for the effect
+            Timeline_add_line_clear(timeline, game);
+            GameMetrics_lock(metrics, &game->active_piece);
+            EventLog_emit(event_log, EventLock, game, metrics->time, 0);
+            int deleted_rows = Game_lock_active_piece(game, *start_level, &next_level);
+            GameMetrics_lines(metrics, deleted_rows);
+            if (deleted_rows > 0) {
+                EventLog_emit(event_log, EventLineClear, game, metrics->time, deleted_rows);
+                EventLog_emit(event_log, EventScore, game, metrics->time, game->score);
+            }
             // SOUND
             switch (deleted_rows) {
             case 1:
             case 2:
             case 3:
-                PlaySound(*line_clear_sound);
+                SfxMixer_play(sfx, SfxLineClear);
                 break;
             case 4:
-                PlaySound(*tetris_sound);
+                SfxMixer_play(sfx, SfxTetris);
                 break;
             }
-            Game_update_score(game, deleted_rows);
+            // PARTICLES: every deleted square bursts with its color, the last event of
+            // the timeline is the line clear just added
+            if (deleted_rows > 0) {
+                const AnimationEvent* clear = &timeline->events[timeline->count - 1];
+                int per_square = deleted_rows == 4 ? TETRIS_PARTICLES_PER_SQUARE : PARTICLES_PER_SQUARE;
+                for (int i = 0; i < clear->row_count; ++i) {
+                    for (int col = 0; col < game->cols; ++col) {
+                        ParticlePool_emit(
+                            particles,
+                            (float)(col * SQUARE_SIZE + GUI_SIZE),
+                            (float)((clear->rows[i] - HIDDEN_ROWS) * SQUARE_SIZE),
+                            SQUARE_SIZE,
+                            SQUARE_SIZE,
+                            per_square,
+                            (uint32_t)ColorToInt(ColorFromPiece(clear->cleared[i][col].type)),
+                            PARTICLE_SPEED,
+                            PARTICLE_LIFE);
+                    }
+                }
+            }
             // Change level if need
-            if ((game->current_level == *start_level && A_TYPE_P(*start_level, game->destroyed_lines)) || (game->current_level > *start_level && (game->destroyed_lines >= ((*start_level * 10 + 10) + (game->current_level - *start_level) * 10)))) {
-                game->current_level += 1;
+            if (next_level) {
                 *level_delay = LEVEL_TIME(game->current_level);
-                PlaySound(*next_level_sound);
+                SfxMixer_play(sfx, SfxNextLevel);
+                ParticlePool_emit(particles, GUI_SIZE, 0.0f, game->cols * SQUARE_SIZE, game->rows * SQUARE_SIZE, LEVEL_UP_PARTICLES, (uint32_t)ColorToInt(GOLD), PARTICLE_SPEED / 2.0f, PARTICLE_LIFE);
             }
             *game_over = Game_check_game_over(game);
+            if (next_level) {
+                EventLog_emit(event_log, EventLevel, game, metrics->time, game->current_level);
+            }
+            EventLog_emit(event_log, *game_over ? EventGameOver : EventSpawn, game, metrics->time, game->score);
         }
     }
 
@@ -542,365 +971,224 @@ void play_screen_logic(
         *level_timer += GetFrameTime();
     }
     *delta_time += GetFrameTime();
+    GameMetrics_tick(metrics, GetFrameTime());
 }
 
-int Piece_left_square(Piece* piece)
+void endless_screen_input(
+    EndlessGame* game,
+    Sound* theme,
+    float* move_timer,
+    float* move_delay,
+    float* level_timer,
+    float* level_delay,
+    bool* music_paused,
+    bool* is_soft_drop,
+    bool* level_selection_screen,
+    bool* paused,
+    int start_level)
 {
-    int min_col = 100;
-    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
-        if (piece->squares[i][1] < min_col) {
-            min_col = piece->squares[i][1];
-        }
+    if (IsKeyPressed(KEY_R) || IsKeyPressed(KEY_L)) {
+        *level_selection_screen = IsKeyPressed(KEY_L);
+        EndlessGame_reset(game, start_level);
+        *level_delay = LEVEL_TIME(start_level);
+        return;
     }
-    return min_col;
-}
-
-int Piece_right_square(Piece* piece)
-{
-    int max_col = 0;
-    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
-        if (piece->squares[i][1] > max_col) {
-            max_col = piece->squares[i][1];
-        }
+    if (game->game_over) {
+        return;
     }
-    return max_col;
-}
-
-void Piece_rotate(Piece* piece, float direction, Game* game)
-{
-    const float degree = direction * PI / 2.0f;
-    const Square* origin = &piece->squares[1];
-
-    Square rotated_points[4] = { 0 };
 
-    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
-        const float x0 = (float)piece->squares[i][0] - (float)(*origin)[0];
-        const float y0 = (float)piece->squares[i][1] - (float)(*origin)[1];
-
-        int x1 = (int)(roundf(x0 * cosf(degree) - y0 * sinf(degree)));
-        int y1 = (int)(roundf(x0 * sinf(degree) + y0 * cosf(degree)));
-        x1 += (float)(*origin)[0];
-        y1 += (float)(*origin)[1];
-
-        Square points = { x1, y1 };
-        memcpy(rotated_points[i], points, sizeof(points));
-
-        if (x1 < 0 || x1 >= TOTAL_ROWS || y1 < 0 || y1 >= COLS || Game_touch_other_square(game, points)) {
-            return;
-        }
+    // Hold down a key for continuous moving
+    if (IsKeyDown(KEY_RIGHT) && *move_timer >= *move_delay) {
+        EndlessGame_move_active_piece(game, Right);
+        *move_timer = 0.0f;
     }
-
-    memcpy(piece->squares, rotated_points, sizeof(rotated_points));
-}
-
-Piece spawn_piece(void)
-{
-    PieceKind piece_kind_to_spawn = PieceKind_get_random();
-    Piece piece_to_spawn = { 0 };
-    piece_to_spawn.kind = piece_kind_to_spawn;
-
-    switch (piece_kind_to_spawn) {
-    case T:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 3, 5 },
-                                           { 2, 5 },
-                                           { 2, 4 },
-                                           { 2, 6 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case I:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 2, 4 },
-                                           { 2, 5 },
-                                           { 2, 6 },
-                                           { 2, 7 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case J:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 3, 4 },
-                                           { 3, 5 },
-                                           { 3, 6 },
-                                           { 2, 6 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case Z:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 2, 6 },
-                                           { 2, 5 },
-                                           { 3, 4 },
-                                           { 3, 5 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case O:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 3, 4 },
-                                           { 3, 5 },
-                                           { 2, 4 },
-                                           { 2, 5 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case S:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 3, 6 },
-                                           { 3, 5 },
-                                           { 2, 5 },
-                                           { 2, 4 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case L:
-        memcpy(piece_to_spawn.squares, (Square[4]) {
-                                           { 3, 4 },
-                                           { 3, 5 },
-                                           { 3, 6 },
-                                           { 2, 4 },
-                                       },
-            sizeof(piece_to_spawn.squares));
-        break;
-    case Empty:
-        printf("ERROR: Trying to spawn an EMPTY PIECE\n");
-        assert(false);
-        break;
-    }
-
-    return piece_to_spawn;
-}
-
-Game Game_init(int level)
-{
-    Board board = { 0 };
-    for (int row = 0; row < ARRAY_LEN_INT(board); ++row) {
-        for (int col = 0; col < ARRAY_LEN_INT(board[col]); ++col) {
-            board[row][col].active = false;
-            board[row][col].type = Empty;
-        }
+    if (IsKeyDown(KEY_LEFT) && *move_timer >= *move_delay) {
+        EndlessGame_move_active_piece(game, Left);
+        *move_timer = 0.0f;
     }
-
-    Game game = (Game) {
-        .active_piece = spawn_piece(),
-        .next_piece = spawn_piece(),
-        .destroyed_lines = 0,
-        .score = 0,
-        .best_score = 0,
-        .current_level = level
-    };
-    memcpy(game.board, board, sizeof(board));
-
-    return game;
-}
-
-void Game_reset(Game* game, int start_level)
-{
-    Game to_copy = Game_init(start_level);
-    to_copy.best_score = game->best_score;
-    to_copy.score = game->score;
-    memcpy(game, &to_copy, sizeof(to_copy));
-
-    if (game->score > game->best_score) {
-        game->best_score = game->score;
+    if (IsKeyPressed(KEY_Z)) {
+        EndlessGame_rotate_active_piece(game, Left);
     }
-    game->score = 0;
-}
-
-bool Game_touch_other_square(const Game* game, Square square)
-{
-    if (game->board[square[0]][square[1]].active == true) {
-        return true;
+    if (IsKeyPressed(KEY_X)) {
+        EndlessGame_rotate_active_piece(game, Right);
     }
-    return false;
-}
-
-bool Game_active_piece_can_go_right(Game* game)
-{
-    int active_right = Piece_right_square(&game->active_piece);
-    if (active_right == COLS - 1) {
-        return false;
+    // Hard drop, the logic locks the piece in the same frame
+    if (IsKeyPressed(KEY_SPACE)) {
+        EndlessGame_hard_drop_active_piece(game);
+        *level_timer = *level_delay;
     }
 
-    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-        Square next = { game->active_piece.squares[i][0], game->active_piece.squares[i][1] + 1 };
-        if (Game_touch_other_square(game, next)) {
-            return false;
+    bool left_window = false;
+#ifndef PLATFORM_WEB
+    left_window = !IsWindowFocused();
+#endif
+    if (IsKeyPressed(KEY_P) || left_window) {
+        *paused = true;
+        PauseSound(*theme);
+        return;
+    }
+    if (IsKeyPressed(KEY_M)) {
+        if (IsSoundPlaying(*theme)) {
+            PauseSound(*theme);
+        } else {
+            ResumeSound(*theme);
         }
+        *music_paused = !(*music_paused);
     }
 
-    return true;
-}
-
-bool Game_active_piece_can_go_left(Game* game)
-{
-    int active_left = Piece_left_square(&game->active_piece);
-    if (active_left == 0)
-        return false;
-
-    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-        Square next = { game->active_piece.squares[i][0], game->active_piece.squares[i][1] - 1 };
-        if (Game_touch_other_square(game, next)) {
-            return false;
+    // Soft drop, as in the play screen
+    if (IsKeyDown(KEY_DOWN)) {
+        *is_soft_drop = true;
+        if (game->rules.current_level < 19) {
+            *level_timer += (*level_delay) / 2;
         }
     }
-
-    return true;
+    if (IsKeyReleased(KEY_DOWN)) {
+        *is_soft_drop = false;
+    }
 }
 
-bool Game_gravity_active_piece(Game* game)
+void endless_screen_render(
+    const EndlessGame* game,
+    const RenderQuality* quality,
+    const Bloom* bloom,
+    bool paused,
+    float delta_time,
+    float camera,
+    const Screen* screen)
 {
-    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-        Square next = { game->active_piece.squares[i][0] + 1, game->active_piece.squares[i][1] };
-        if (next[0] == TOTAL_ROWS) {
-            return true;
-        }
+    const int screen_width = screen->width;
+    const int screen_height = screen->height;
+    const int view_rows = screen_height / SQUARE_SIZE;
+    const Color background = { 0x1E, 0x20, 0x1E, 0xFF };
+    BeginDrawing();
 
-        if (Game_touch_other_square(game, next)) {
-            return true;
-        }
+    bool bloom_enabled = bloom->level_count > 0;
+    if (bloom_enabled) {
+        Bloom_begin(bloom, background);
+        EndlessGame_draw_on_window(game, camera, view_rows, GUI_SIZE, quality, delta_time);
+        Bloom_end(bloom);
     }
 
-    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-        game->active_piece.squares[i][0] += 1;
+    Screen_begin(screen);
+    ClearBackground(background);
+    if (bloom_enabled) {
+        Bloom_draw(bloom);
+    } else {
+        EndlessGame_draw_on_window(game, camera, view_rows, GUI_SIZE, quality, delta_time);
     }
 
-    return false;
-}
+    // GUI DRAWING
+    DrawRectangleLinesEx((Rectangle) { 0, 0, GUI_SIZE, screen_height }, 15, (Color) { 0x3C, 0x3D, 0x37, 0xFF });
+    DrawText("Score:", 25, 50, 25, LIGHTGRAY);
+    DrawText(TextFormat("%d", game->rules.score), 110, 51, 25, SKYBLUE);
+    DrawText("Best Score:", 25, 100, 25, LIGHTGRAY);
+    DrawText(TextFormat("%d", game->rules.best_score), 175, 101, 25, SKYBLUE);
+    DrawText("Del. Lines:", 25, 150, 25, LIGHTGRAY);
+    DrawText(TextFormat("%d", game->rules.destroyed_lines), 150, 151, 25, SKYBLUE);
+    DrawText("Level:", 25, 200, 25, LIGHTGRAY);
+    DrawText(TextFormat("%d", game->rules.current_level), 100, 201, 25, SKYBLUE);
+    DrawText("Height:", 25, 250, 25, LIGHTGRAY);
+    DrawText(TextFormat("%d / %d", game->board.height, game->board.max_rows), 125, 251, 25, SKYBLUE);
+    DrawText(TextFormat("Shader %s%s", QualityTier_name(quality->tier), quality->automatic ? " (auto)" : ""), 25, 320, 20, GRAY);
+
+    DrawText("Next Piece", GUI_SIZE / 2 - 75, 420, 25, LIGHTGRAY);
+    PieceKind_draw_preview(Game_next_kind(&game->rules, 0), GUI_SIZE / 2 - 2 * SQUARE_SIZE, 480, SQUARE_SIZE, quality);
+    const float small_size = SQUARE_SIZE * 0.4f;
+    for (int i = 1; i < game->rules.preview_length; ++i) {
+        float x = 25.0f + (float)((i - 1) % 3) * (GUI_SIZE - 50) / 3.0f;
+        float y = (float)(4 * SQUARE_SIZE + 530) + (float)((i - 1) / 3) * 3.0f * small_size;
+        PieceKind_draw_preview(Game_next_kind(&game->rules, i), x, y, small_size, quality);
+    }
 
-void Game_release_active_piece(Game* game)
-{
-    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-        Square* curr_square = &game->active_piece.squares[i];
-        memcpy(
-            (void*)&game->board[(*curr_square)[0]][(*curr_square)[1]],
-            &(Slot) { .active = true, .type = game->active_piece.kind },
-            sizeof(Slot));
+    if (paused) {
+        DrawRectangle(GUI_SIZE, 0, screen_width - GUI_SIZE, screen_height, Fade(BLACK, 0.6f));
+        DrawText("Paused", GUI_SIZE + 25, screen_height / 3, 30, RAYWHITE);
+        DrawText("Press P to continue", GUI_SIZE + 25, screen_height / 3 + 40, 25, LIGHTGRAY);
+    } else if (game->game_over) {
+        DrawRectangle(GUI_SIZE, 0, screen_width - GUI_SIZE, screen_height, Fade(BLACK, 0.6f));
+        DrawText("Si pers fra :(", GUI_SIZE + 25, screen_height / 3, 30, DARKBLUE);
+        DrawText("Schiaccj lu tast R per continua'", GUI_SIZE + 25, screen_height / 3 + 40, 25, LIME);
     }
 
-    game->active_piece = game->next_piece;
-    game->next_piece = spawn_piece();
+    Screen_end(screen);
+    Screen_draw(screen);
+    EndDrawing();
 }
 
-void Game_move_active_piece(Game* game, Direction direction)
+void endless_screen_logic(
+    EndlessGame* game,
+    Sound* theme,
+    SfxMixer* sfx,
+    int start_level,
+    float* delta_time,
+    float* level_timer,
+    float* level_delay,
+    float* move_timer,
+    bool* is_soft_drop,
+    bool* music_paused,
+    int view_rows,
+    float* camera)
 {
-    switch (direction) {
-    case Left:
-        if (Game_active_piece_can_go_left(game) == true) {
-            for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-                game->active_piece.squares[i][1] -= 1;
+    if (*level_timer >= *level_delay) {
+        *level_timer = 0.0f;
+        if (EndlessGame_gravity_active_piece(game) == true) {
+            bool next_level = false;
+            int deleted_rows = EndlessGame_lock_active_piece(game, start_level, &next_level);
+            if (deleted_rows == 4) {
+                SfxMixer_play(sfx, SfxTetris);
+            } else if (deleted_rows > 0) {
+                SfxMixer_play(sfx, SfxLineClear);
             }
-        }
-        break;
-    case Right:
-        if (Game_active_piece_can_go_right(game) == true) {
-            for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-                game->active_piece.squares[i][1] += 1;
+            if (next_level) {
+                *level_delay = LEVEL_TIME(game->rules.current_level);
+                SfxMixer_play(sfx, SfxNextLevel);
             }
         }
-        break;
-    }
-}
-
-void Game_rotate_active_piece(Game* game, Direction direction)
-{
-    switch (direction) {
-    case Left:
-        Piece_rotate(&game->active_piece, -1.0f, game);
-        break;
-    case Right:
-        Piece_rotate(&game->active_piece, 1.0f, game);
-        break;
     }
-}
-
-void Game_update_score(Game* game, int lines)
-{
-    int score = 0;
-    switch (lines) {
-    case 1:
-        score = 40 * (game->current_level + 1);
-        break;
-    case 2:
-        score = 100 * (game->current_level + 1);
-        break;
-    case 3:
-        score = 300 * (game->current_level + 1);
-        break;
-    case 4:
-        score = 1200 * (game->current_level + 1);
-        break;
-    }
-
-    game->score += score;
-}
 
-int Game_delete_full_rows_if_exists(Game* game)
-{
-    int deleted_rows = 0;
-
-    for (int row = 0; row < ARRAY_LEN_INT(game->board); ++row) {
-        bool full_row = true;
-
-        // Check if the row is full
-        for (int col = 0; col < ARRAY_LEN_INT(game->board[row]); ++col) {
-            if (game->board[row][col].active == false) {
-                full_row = false;
-                break;
-            }
-        }
-
-        // Delete the row
-        if (full_row == true) {
-            deleted_rows += 1;
+    // The view glides to the piece instead of jumping at every spawn
+    float target = (float)EndlessGame_camera_target(game, view_rows);
+    *camera += (target - *camera) * fminf(1.0f, GetFrameTime() * ENDLESS_CAMERA_SPEED);
 
-            int row_start = row;
-
-            while (row_start > 0) {
-                for (int col = 0; col < ARRAY_LEN_INT(game->board[row]); ++col) {
-                    memcpy(&game->board[row_start][col], &game->board[row_start - 1][col], sizeof(Slot));
-                }
-                row_start -= 1;
-            }
-        }
+    // Audio
+    if (!IsSoundPlaying(*theme) && !(*music_paused)) {
+        PlaySound(*theme);
     }
-    game->destroyed_lines += deleted_rows;
-    return deleted_rows;
-}
-
-bool Game_check_game_over(Game* game)
-{
-    for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
-        if (game->board[game->active_piece.squares[i][0]][game->active_piece.squares[i][1]].active == true) {
-            return true;
-        }
+    *move_timer += GetFrameTime();
+    if (!(*is_soft_drop)) {
+        *level_timer += GetFrameTime();
     }
-
-    return false;
+    *delta_time += GetFrameTime();
 }
 
-void Game_draw_on_window(const Game* game, int starting_x, Shader shader, float delta_time)
+void Game_draw_on_window(const Game* game, const Timeline* timeline, int starting_x, const RenderQuality* quality, float delta_time)
 {
+    Shader shader = RenderQuality_shader(quality);
     int shader_loc = GetShaderLocation(shader, "time");
     SetShaderValue(shader, shader_loc, &delta_time, SHADER_UNIFORM_FLOAT);
 
-    for (int row = 0; row < ARRAY_LEN_INT(game->board); ++row) {
+    for (int row = 0; row < game->rows + HIDDEN_ROWS; ++row) {
         if (row < HIDDEN_ROWS) {
             continue;
         }
+        // Rows above a line clear start where they were and fall in place
+        float row_y = (float)((row - HIDDEN_ROWS) * SQUARE_SIZE);
+        if (timeline != nullptr) {
+            row_y -= Timeline_row_offset(timeline, row) * SQUARE_SIZE;
+        }
 
-        for (int col = 0; col < ARRAY_LEN_INT(game->board[row]); ++col) {
+        for (int col = 0; col < game->cols; ++col) {
             const Slot* curr_square = &game->board[row][col];
             if (curr_square->active == true) {
                 Rectangle to_draw = {
                     .x = (float)(col * SQUARE_SIZE + starting_x),
-                    .y = (float)(row * SQUARE_SIZE - HIDDEN_ROWS * SQUARE_SIZE),
+                    .y = row_y,
                     .width = (float)SQUARE_SIZE,
                     .height = (float)SQUARE_SIZE
                 };
 
-                BeginShaderMode(shader);
+                RenderQuality_begin(quality);
 
                 DrawRectangleRec(to_draw, ColorFromPiece(game->board[row][col].type));
 
@@ -912,6 +1200,30 @@ void Game_draw_on_window(const Game* game, int starting_x, Shader shader, float
         }
     }
 
+    if (timeline != nullptr) {
+        for (int i = 0; i < timeline->count; ++i) {
+            if (timeline->events[i].kind == LineClear) {
+                AnimationEvent_draw_line_clear(&timeline->events[i], timeline->time, starting_x, game->cols, quality);
+            }
+        }
+    }
+
+    // Ghost piece: where the active piece lands
+    int drop_distance = Game_drop_distance(game);
+    if (drop_distance > 0) {
+        Color ghost_color = ColorFromPiece(game->active_piece.kind);
+        for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
+            Rectangle rect = {
+                .x = (float)(game->active_piece.squares[i][1] * SQUARE_SIZE + starting_x),
+                .y = (float)((game->active_piece.squares[i][0] + drop_distance) * SQUARE_SIZE - HIDDEN_ROWS * SQUARE_SIZE),
+                .width = SQUARE_SIZE,
+                .height = SQUARE_SIZE,
+            };
+            DrawRectangleRec(rect, Fade(ghost_color, 0.2f));
+            DrawRectangleLinesEx(rect, LINE_THICKNESS, Fade(ghost_color, 0.6f));
+        }
+    }
+
     for (int i = 0; i < ARRAY_LEN_INT(game->active_piece.squares); ++i) {
         Rectangle rect = {
             .x = (float)(game->active_piece.squares[i][1] * SQUARE_SIZE + starting_x),
@@ -920,10 +1232,179 @@ void Game_draw_on_window(const Game* game, int starting_x, Shader shader, float
             .height = SQUARE_SIZE,
         };
 
-        BeginShaderMode(shader);
+        RenderQuality_begin(quality);
         DrawRectangleRec(rect, ColorFromPiece(game->active_piece.kind));
         EndShaderMode();
 
         DrawRectangleLinesEx(rect, LINE_THICKNESS, BLACK);
     }
 }
+
+void EndlessGame_draw_on_window(const EndlessGame* game, float camera, int view_rows, int starting_x, const RenderQuality* quality, float delta_time)
+{
+    Shader shader = RenderQuality_shader(quality);
+    int shader_loc = GetShaderLocation(shader, "time");
+    SetShaderValue(shader, shader_loc, &delta_time, SHADER_UNIFORM_FLOAT);
+
+    const EndlessBoard* board = &game->board;
+    const float width = (float)(board->cols * SQUARE_SIZE);
+    // Rows go up from the bottom of the board: row is drawn from (top_row - row) * SQUARE_SIZE
+    const float top_row = camera + (float)view_rows - 1.0f;
+
+    // Only the rows in the view (the lowest and the highest can be cut in half)
+    int first_row = (int)floorf(camera);
+    int last_row = first_row + view_rows + 1;
+    if (last_row > board->height) {
+        last_row = board->height;
+    }
+
+    // Marks of the height under the squares
+    for (int row = (first_row / ENDLESS_MARK_ROWS + 1) * ENDLESS_MARK_ROWS; row <= first_row + view_rows + 1; row += ENDLESS_MARK_ROWS) {
+        float y = (top_row - (float)(row - 1)) * SQUARE_SIZE;
+        DrawLineEx((Vector2) { (float)starting_x, y }, (Vector2) { (float)starting_x + width, y }, LINE_THICKNESS, Fade(LIGHTGRAY, 0.2f));
+        DrawText(TextFormat("%d", row), starting_x + 5, (int)y + 5, 20, Fade(LIGHTGRAY, 0.4f));
+    }
+
+    // One shader mode for all the squares of the board
+    RenderQuality_begin(quality);
+    for (int row = first_row; row < last_row; ++row) {
+        const Slot* slots = EndlessBoard_row(board, row);
+        for (int col = 0; col < board->cols; ++col) {
+            if (slots[col].active) {
+                Rectangle to_draw = {
+                    .x = (float)(col * SQUARE_SIZE + starting_x),
+                    .y = (top_row - (float)row) * SQUARE_SIZE,
+                    .width = (float)SQUARE_SIZE,
+                    .height = (float)SQUARE_SIZE
+                };
+                DrawRectangleRec(to_draw, ColorFromPiece(slots[col].type));
+                DrawRectangleLinesEx(to_draw, LINE_THICKNESS, BLACK);
+            }
+        }
+    }
+    EndShaderMode();
+
+    // Ghost piece: where the active piece lands
+    const Piece* piece = &game->active_piece;
+    int drop_distance = EndlessGame_drop_distance(game);
+    if (drop_distance > 0) {
+        Color ghost_color = ColorFromPiece(piece->kind);
+        for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+            Rectangle rect = {
+                .x = (float)(piece->squares[i][1] * SQUARE_SIZE + starting_x),
+                .y = (top_row - (float)(piece->squares[i][0] - drop_distance)) * SQUARE_SIZE,
+                .width = SQUARE_SIZE,
+                .height = SQUARE_SIZE,
+            };
+            DrawRectangleRec(rect, Fade(ghost_color, 0.2f));
+            DrawRectangleLinesEx(rect, LINE_THICKNESS, Fade(ghost_color, 0.6f));
+        }
+    }
+
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        Rectangle rect = {
+            .x = (float)(piece->squares[i][1] * SQUARE_SIZE + starting_x),
+            .y = (top_row - (float)piece->squares[i][0]) * SQUARE_SIZE,
+            .width = SQUARE_SIZE,
+            .height = SQUARE_SIZE,
+        };
+
+        RenderQuality_begin(quality);
+        DrawRectangleRec(rect, ColorFromPiece(piece->kind));
+        EndShaderMode();
+
+        DrawRectangleLinesEx(rect, LINE_THICKNESS, BLACK);
+    }
+}
+
+void BotOpponent_draw_on_window(const BotOpponent* opponent, int starting_x, const RenderQuality* quality, float delta_time)
+{
+    Game_draw_on_window(&opponent->display, nullptr, starting_x, quality, delta_time);
+    DrawLineEx((Vector2) { (float)starting_x, 0.0f }, (Vector2) { (float)starting_x, (float)(ROWS * SQUARE_SIZE) }, 4.0f, (Color) { 0x3C, 0x3D, 0x37, 0xFF });
+
+    char status[64] = { 0 };
+    sprintf(status, "%s: %d", opponent->bot.name, opponent->display.score);
+    DrawText(status, starting_x + 15, 15, 20, LIGHTGRAY);
+    if (opponent->game_over) {
+        DrawText("Game over", starting_x + 15, 40, 20, RED);
+    } else if (!opponent->bot.alive) {
+        DrawText("Bot disconnected", starting_x + 15, 40, 20, RED);
+    }
+}
+
+void AnimationEvent_draw_line_clear(const AnimationEvent* event, float time, int starting_x, int cols, const RenderQuality* quality)
+{
+    float progress = AnimationEvent_progress(event, time) / LINE_CLEAR_FALL_START;
+    if (progress >= 1.0f) {
+        return;
+    }
+    float size = SQUARE_SIZE * (1.0f - progress);
+
+    for (int i = 0; i < event->row_count; ++i) {
+        if (event->rows[i] < HIDDEN_ROWS) {
+            continue;
+        }
+        float y = (float)((event->rows[i] - HIDDEN_ROWS) * SQUARE_SIZE);
+
+        for (int col = 0; col < cols; ++col) {
+            Rectangle rect = {
+                .x = (float)(col * SQUARE_SIZE + starting_x) + (SQUARE_SIZE - size) / 2.0f,
+                .y = y + (SQUARE_SIZE - size) / 2.0f,
+                .width = size,
+                .height = size,
+            };
+
+            RenderQuality_begin(quality);
+            DrawRectangleRec(rect, ColorFromPiece(event->cleared[i][col].type));
+            EndShaderMode();
+        }
+
+        // A tetris flashes brighter
+        float flash = (event->row_count == 4 ? 0.8f : 0.5f) * (1.0f - progress);
+        DrawRectangleRec((Rectangle) { (float)starting_x, y, (float)(cols * SQUARE_SIZE), (float)SQUARE_SIZE }, Fade(RAYWHITE, flash));
+    }
+}
+
+void PieceKind_draw_preview(PieceKind kind, float x, float y, float square_size, const RenderQuality* quality)
+{
+    Piece piece = Piece_spawn(kind);
+
+    // Spawn squares start from row 2 and column 4
+    for (int i = 0; i < ARRAY_LEN_INT(piece.squares); ++i) {
+        Rectangle rect = {
+            .x = x + (float)(piece.squares[i][1] - 4) * square_size,
+            .y = y + (float)(piece.squares[i][0] - 2) * square_size,
+            .width = square_size,
+            .height = square_size,
+        };
+
+        RenderQuality_begin(quality);
+        DrawRectangleRec(rect, ColorFromPiece(kind));
+        EndShaderMode();
+
+        DrawRectangleLinesEx(rect, LINE_THICKNESS, BLACK);
+    }
+}
+
+void ParticlePool_draw(const ParticlePool* pool, float size)
+{
+    for (int first = 0; first < pool->count; first += PARTICLES_DRAW_CHUNK) {
+        int last = first + PARTICLES_DRAW_CHUNK < pool->count ? first + PARTICLES_DRAW_CHUNK : pool->count;
+        rlCheckRenderBatchLimit(4 * (last - first));
+
+        rlBegin(RL_QUADS);
+        for (int i = first; i < last; ++i) {
+            uint32_t color = pool->color[i];
+            float fade = pool->life[i] < 0.25f ? pool->life[i] * 4.0f : 1.0f;
+            rlColor4ub(color >> 24, (color >> 16) & 0xFF, (color >> 8) & 0xFF, (unsigned char)((float)(color & 0xFF) * fade));
+
+            float x = pool->x[i];
+            float y = pool->y[i];
+            rlVertex2f(x, y);
+            rlVertex2f(x, y + size);
+            rlVertex2f(x + size, y + size);
+            rlVertex2f(x + size, y);
+        }
+        rlEnd();
+    }
+}
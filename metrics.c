@@ -0,0 +1,240 @@
+#include <string.h>
+
+#include "metrics.h"
+
+// Horizontal shifts from the spawn column that the search can reach
+#define FINESSE_SHIFTS (2 * COLS + 1)
+
+/*
+    The spawn piece after rotation clockwise rotations and shift columns to the right
+    (rotating around the pivot and moving commute)
+*/
+Piece FinesseTable_piece(const Piece rotated[4], int rotation, int shift);
+
+void FinesseTable_build(FinesseTable* table)
+{
+    memset(table->inputs, FINESSE_UNREACHABLE, sizeof(table->inputs));
+    Game game = Game_init(0, 0, Uniform);
+
+    for (int kind = 0; kind < Empty; ++kind) {
+        Piece rotated[4] = { Piece_spawn((PieceKind)kind) };
+        int orientation[4] = { 0 };
+        for (int r = 0; r < 4; ++r) {
+            if (r > 0) {
+                rotated[r] = rotated[r - 1];
+                Piece_rotate(&rotated[r], 1.0f, &game);
+            }
+            table->shapes[kind][r] = Piece_shape_mask(&rotated[r]);
+            orientation[r] = r;
+            for (int o = 0; o < r; ++o) {
+                if (table->shapes[kind][o] == table->shapes[kind][r]) {
+                    orientation[r] = o;
+                    break;
+                }
+            }
+        }
+
+        // Breadth first search on (rotation, shift), every edge is one press
+        uint8_t distance[4][FINESSE_SHIFTS];
+        memset(distance, FINESSE_UNREACHABLE, sizeof(distance));
+        int queue[4 * FINESSE_SHIFTS][2];
+        int head = 0;
+        int tail = 0;
+        distance[0][COLS] = 0;
+        queue[tail][0] = 0;
+        queue[tail++][1] = 0;
+
+        while (head < tail) {
+            int rotation = queue[head][0];
+            int shift = queue[head++][1];
+            Piece piece = FinesseTable_piece(rotated, rotation, shift);
+
+            int col = Piece_left_square(&piece);
+            uint8_t* best = &table->inputs[kind][orientation[rotation]][col];
+            if (distance[rotation][shift + COLS] < *best) {
+                *best = distance[rotation][shift + COLS];
+            }
+
+            int next[6][2] = { 0 };
+            int count = 0;
+            for (int d = 0; d < 2; ++d) {
+                Direction direction = d == 0 ? Left : Right;
+                int step = d == 0 ? -1 : 1;
+
+                // Tap
+                game.active_piece = piece;
+                Game_move_active_piece(&game, direction);
+                if (Piece_left_square(&game.active_piece) != col) {
+                    next[count][0] = rotation;
+                    next[count++][1] = shift + step;
+                }
+
+                // Hold until the wall
+                game.active_piece = piece;
+                int wall = col;
+                while (true) {
+                    Game_move_active_piece(&game, direction);
+                    if (Piece_left_square(&game.active_piece) == wall) {
+                        break;
+                    }
+                    wall = Piece_left_square(&game.active_piece);
+                }
+                if (wall != col) {
+                    next[count][0] = rotation;
+                    next[count++][1] = shift + wall - col;
+                }
+
+                game.active_piece = piece;
+                if (Game_rotate_active_piece(&game, direction)) {
+                    next[count][0] = (rotation + (d == 0 ? 3 : 1)) % 4;
+                    next[count++][1] = shift;
+                }
+            }
+
+            for (int i = 0; i < count; ++i) {
+                uint8_t* seen = &distance[next[i][0]][next[i][1] + COLS];
+                if (*seen == FINESSE_UNREACHABLE) {
+                    *seen = distance[rotation][shift + COLS] + 1;
+                    queue[tail][0] = next[i][0];
+                    queue[tail++][1] = next[i][1];
+                }
+            }
+        }
+    }
+}
+
+Piece FinesseTable_piece(const Piece rotated[4], int rotation, int shift)
+{
+    Piece piece = rotated[rotation];
+    for (int i = 0; i < ARRAY_LEN_INT(piece.squares); ++i) {
+        piece.squares[i][1] += shift;
+    }
+    return piece;
+}
+
+int FinesseTable_inputs(const FinesseTable* table, const Piece* piece)
+{
+    uint16_t mask = Piece_shape_mask(piece);
+    Piece copy = *piece;
+    int col = Piece_left_square(&copy);
+
+    for (int o = 0; o < 4; ++o) {
+        if (table->shapes[piece->kind][o] == mask) {
+            return table->inputs[piece->kind][o][col];
+        }
+    }
+    return FINESSE_UNREACHABLE;
+}
+
+uint16_t Piece_shape_mask(const Piece* piece)
+{
+    int top = piece->squares[0][0];
+    int left = piece->squares[0][1];
+    for (int i = 1; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        top = piece->squares[i][0] < top ? piece->squares[i][0] : top;
+        left = piece->squares[i][1] < left ? piece->squares[i][1] : left;
+    }
+
+    uint16_t mask = 0;
+    for (int i = 0; i < ARRAY_LEN_INT(piece->squares); ++i) {
+        mask |= (uint16_t)(1u << ((piece->squares[i][0] - top) * 4 + (piece->squares[i][1] - left)));
+    }
+    return mask;
+}
+
+void GameMetrics_init(GameMetrics* metrics, const FinesseTable* finesse)
+{
+    *metrics = (GameMetrics) { .finesse = finesse };
+}
+
+void GameMetrics_reset(GameMetrics* metrics)
+{
+    *metrics = (GameMetrics) { .finesse = metrics->finesse, .games = metrics->games };
+}
+
+void GameMetrics_press(GameMetrics* metrics, InputKind kind)
+{
+    metrics->keys += 1;
+    if (kind == InputMove || kind == InputRotate) {
+        metrics->piece_presses += 1;
+    }
+}
+
+void GameMetrics_action(GameMetrics* metrics)
+{
+    metrics->actions += 1;
+}
+
+void GameMetrics_lock(GameMetrics* metrics, const Piece* piece)
+{
+    int inputs = metrics->finesse != nullptr ? FinesseTable_inputs(metrics->finesse, piece) : FINESSE_UNREACHABLE;
+    if (inputs != FINESSE_UNREACHABLE && metrics->piece_presses > inputs) {
+        metrics->finesse_faults += metrics->piece_presses - inputs;
+    }
+    metrics->piece_presses = 0;
+    metrics->pieces += 1;
+}
+
+void GameMetrics_lines(GameMetrics* metrics, int deleted_rows)
+{
+    metrics->tetrises += deleted_rows == 4;
+}
+
+void GameMetrics_tick(GameMetrics* metrics, float delta_time)
+{
+    metrics->time += delta_time;
+}
+
+float GameMetrics_pps(const GameMetrics* metrics)
+{
+    return metrics->time > 0.0f ? (float)metrics->pieces / metrics->time : 0.0f;
+}
+
+float GameMetrics_kpp(const GameMetrics* metrics)
+{
+    return metrics->pieces > 0 ? (float)metrics->keys / (float)metrics->pieces : 0.0f;
+}
+
+float GameMetrics_apm(const GameMetrics* metrics)
+{
+    return metrics->time > 0.0f ? (float)metrics->actions * 60.0f / metrics->time : 0.0f;
+}
+
+void GameResult_write_csv_header(FILE* file)
+{
+    fprintf(file, "game,start_level,score,lines,pieces,tetrises,level,topped_out");
+}
+
+void GameResult_write_csv_columns(FILE* file, int game, const GameResult* result)
+{
+    fprintf(file, "%d,%d,%d,%d,%d,%d,%d,%d", game, result->start_level, result->score, result->lines, result->pieces,
+        result->tetrises, result->level, result->topped_out);
+}
+
+void GameMetrics_write_csv_header(FILE* file)
+{
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        GameResult_write_csv_header(file);
+        fprintf(file, ",seconds,pps,kpp,apm,finesse_faults\n");
+    }
+}
+
+void GameMetrics_write_csv_row(FILE* file, GameMetrics* metrics, const Game* game, int start_level)
+{
+    // A game of the player only ends by topping out
+    GameResult result = {
+        .start_level = start_level,
+        .score = game->score,
+        .lines = game->destroyed_lines,
+        .pieces = metrics->pieces,
+        .tetrises = metrics->tetrises,
+        .level = game->current_level,
+        .topped_out = true,
+    };
+    GameResult_write_csv_columns(file, metrics->games, &result);
+    fprintf(file, ",%.2f,%.3f,%.3f,%.1f,%d\n", metrics->time, GameMetrics_pps(metrics), GameMetrics_kpp(metrics),
+        GameMetrics_apm(metrics), metrics->finesse_faults);
+    fflush(file);
+    metrics->games += 1;
+}
@@ -0,0 +1,124 @@
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+
+/*
+    Player metrics of a game, updated as the inputs arrive and the pieces lock:
+
+    PPS      pieces per second
+    KPP      key presses per piece
+    APM      actions per minute, an action is every input applied to the game (a held
+             move key repeats)
+    finesse  extra presses over the fewest that put the pieces where they locked
+*/
+
+#define FINESSE_UNREACHABLE 0xFF
+
+/*
+    Fewest presses to move a piece from its spawn to every (orientation, left column) on
+    an empty board, with taps, rotations and holding a move key until the wall. Built once
+    with a search, then a lock is only a lookup.
+    An orientation is the smallest number of clockwise rotations that gives the shape
+*/
+typedef struct {
+    uint16_t shapes[Empty][4]; // 4x4 box of the piece after r clockwise rotations, bit row * 4 + col
+    uint8_t inputs[Empty][4][COLS];
+} FinesseTable;
+
+typedef enum {
+    InputMove,
+    InputRotate,
+    InputSoftDrop,
+    InputHardDrop,
+} InputKind;
+
+typedef struct {
+    const FinesseTable* finesse; // nullptr to count no finesse faults
+    float time; // seconds played, pauses excluded
+    int pieces;
+    int keys;
+    int actions;
+    int finesse_faults;
+    int tetrises;
+    int piece_presses; // moves and rotations pressed for the active piece
+    int games; // rows written to the CSV in this session, kept by GameMetrics_reset
+} GameMetrics;
+
+/*
+    Outcome of a game: the first columns of every CSV of games, the tournament results and
+    --metrics, so that they can be read by the same tools
+*/
+typedef struct {
+    int start_level;
+    int score;
+    int lines;
+    int pieces;
+    int tetrises;
+    int level;
+    bool topped_out;
+} GameResult;
+
+void FinesseTable_build(FinesseTable* table);
+
+/*
+    Fewest presses to put piece where it is, FINESSE_UNREACHABLE if it cannot get there
+*/
+int FinesseTable_inputs(const FinesseTable* table, const Piece* piece);
+
+/*
+    The squares of piece in a 4x4 box, moved to its top left corner
+*/
+uint16_t Piece_shape_mask(const Piece* piece);
+
+void GameMetrics_init(GameMetrics* metrics, const FinesseTable* finesse);
+
+/*
+    Zero the counters for a new game
+*/
+void GameMetrics_reset(GameMetrics* metrics);
+
+/*
+    A key went down
+*/
+void GameMetrics_press(GameMetrics* metrics, InputKind kind);
+
+/*
+    An input was applied to the game
+*/
+void GameMetrics_action(GameMetrics* metrics);
+
+/*
+    Call it right before the active piece is locked
+*/
+void GameMetrics_lock(GameMetrics* metrics, const Piece* piece);
+
+/*
+    The lock deleted deleted_rows rows
+*/
+void GameMetrics_lines(GameMetrics* metrics, int deleted_rows);
+
+void GameMetrics_tick(GameMetrics* metrics, float delta_time);
+
+float GameMetrics_pps(const GameMetrics* metrics);
+float GameMetrics_kpp(const GameMetrics* metrics);
+float GameMetrics_apm(const GameMetrics* metrics);
+
+/*
+    The GameResult columns, game is the index of the row. No newline: the callers add
+    their own columns
+*/
+void GameResult_write_csv_header(FILE* file);
+void GameResult_write_csv_columns(FILE* file, int game, const GameResult* result);
+
+/*
+    Per game summary as CSV: the GameResult columns, then seconds, PPS, KPP, APM and
+    finesse faults. The header is written only if file is empty
+*/
+void GameMetrics_write_csv_header(FILE* file);
+void GameMetrics_write_csv_row(FILE* file, GameMetrics* metrics, const Game* game, int start_level);
+
+#endif // METRICS_H_
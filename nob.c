@@ -1,5 +1,8 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #define NOB_IMPLEMENTATION
 #define NOB_STRIP_PREFIX
@@ -15,6 +18,472 @@
 
 // #define EMSCRIPTEN
 
+#ifdef __APPLE__
+#define LLVM_PROFDATA "xcrun", "llvm-profdata"
+#define LTO_FLAGS "-flto"
+#define LIBCETRIS "libcetris.dylib"
+#else
+#define LLVM_PROFDATA "llvm-profdata"
+#define LTO_FLAGS "-flto", "-fuse-ld=lld"
+#define LIBCETRIS "libcetris.so"
+#endif
+
+// Every .c of the game, for the native and the web build
+#define GAME_SOURCES "main.c", "game.c", "bot.c", "animation.c", "particles.c", "sfx.c", "metrics.c", "eventlog.c", "leaderboard.c", "quality.c", "bloom.c", "screen.c", "endless.c"
+#define GAME_HEADERS "game.h", "game_board.h", "bot.h", "animation.h", "particles.h", "sfx.h", "metrics.h", "eventlog.h", "leaderboard.h", "quality.h", "bloom.h", "screen.h", "endless.h"
+
+// Kind of build (BuildMode) of every output, an output of another kind is stale
+#define STAMP_DIR ".nob"
+
+// Profile guided build: training profiles, the merged profile and the Release binaries to compare with
+#define PGO_DIR "pgo"
+#define PGO_PROFILE PGO_DIR "/cetris.profdata"
+#define PGO_RUNS 3
+
+// Training (different seeds than the benchmark, so the profile does not learn the benchmark)
+#define PGO_TRAIN_TOURNAMENT "-g", "100", "-d", "2", "-m", "500", "-s", "42"
+#define PGO_BENCH_TOURNAMENT "-g", "150", "-m", "2000", "-s", "7", "-j", "1"
+
+// Test: the same tournament on 1 and on 4 threads must write the same results
+#define TEST_DIR "tests/out"
+#define TEST_TOURNAMENT "-g", "64", "-d", "2", "-m", "300", "-s", "99"
+// Test: steps of GameBatch checked against Game
+#define TEST_BATCH_STEPS "2000"
+
+/*
+    How the programs are compiled:
+    - Debug: debug info, no optimizations
+    - Release: -O3
+    - Static: -O3, the game links raylib statically
+    - Instrumented: -O3 that writes a profile of its run (LLVM_PROFILE_FILE)
+    - Pgo: -O3 with link time optimization, optimized with the merged profile
+*/
+typedef enum {
+    BuildDebug,
+    BuildRelease,
+    BuildStatic,
+    BuildInstrumented,
+    BuildPgo,
+} BuildMode;
+
+const char* build_mode_names[] = {
+    [BuildDebug] = "Debug",
+    [BuildRelease] = "Release",
+    [BuildStatic] = "Static",
+    [BuildInstrumented] = "Instrumented",
+    [BuildPgo] = "Pgo",
+};
+
+/*
+    Something to build: output is compiled from sources with one command. It is built again
+    when it is older than one of its sources, its headers or nob.c (that has the flags), or
+    when it was built with another mode. The lists end with NULL (nob.c is compiled with the
+    default C of the compiler, that may not have nullptr)
+*/
+typedef struct {
+    const char* output;
+    const char** sources;
+    const char** headers;
+    const char** libs; // after the sources
+    bool shared; // shared library
+    bool comp_database; // the compile commands for the editor come from this target
+} Target;
+
+/*
+    The raylib game, see game_target
+*/
+const char* game_sources[] = { GAME_SOURCES, NULL };
+const char* game_headers[] = { GAME_HEADERS, NULL };
+#ifdef __APPLE__
+const char* raylib_libs[] = { "-I/opt/homebrew/include/", "-L/opt/homebrew/lib", "-lraylib", "-Wl,-rpath,/opt/homebrew/lib", NULL };
+const char* raylib_static_libs[] = {
+    "-I/opt/homebrew/include/",
+    "-isysroot",
+    "/Library/Developer/CommandLineTools/SDKs/MacOSX.sdk",
+    "-framework",
+    "Cocoa",
+    "-framework",
+    "OpenGL",
+    "-framework",
+    "IOKit",
+    "-framework",
+    "CoreAudio",
+    "-framework",
+    "CoreVideo",
+    "/opt/homebrew/lib/libraylib.a",
+    "-lm",
+    "-lpthread",
+    NULL,
+};
+#else
+const char* raylib_libs[] = { "-I/usr/include", "-lraylib", "-lm", "-lpthread", NULL };
+#define RAYLIB_STATIC_PATH 1 // index of the libraylib.a of the command line
+const char* raylib_static_libs[] = { "-I/usr/include", "libraylib.a", "-lm", "-lpthread", NULL };
+#endif
+
+/*
+    The headless programs, they do not need raylib
+*/
+Target tournament_target = {
+    .output = "cetris-tournament",
+    .sources = (const char*[]) { "tournament.c", "ai.c", "game.c", "metrics.c", NULL },
+    .headers = (const char*[]) { "ai.h", "game.h", "game_board.h", "metrics.h", NULL },
+    .libs = (const char*[]) { "-lm", "-lpthread", NULL },
+};
+// The AI bot for ./cetris --bot
+Target bot_target = {
+    .output = "cetris-bot",
+    .sources = (const char*[]) { "ai_bot.c", "ai.c", "bot.c", "game.c", NULL },
+    .headers = (const char*[]) { "ai.h", "bot.h", "game.h", "game_board.h", NULL },
+    .libs = (const char*[]) { "-lm", NULL },
+};
+// The environment API (cetris_env.h)
+Target library_target = {
+    .output = LIBCETRIS,
+    .sources = (const char*[]) { "cetris_env.c", "batch.c", "game.c", NULL },
+    .headers = (const char*[]) { "cetris_env.h", "batch.h", "game.h", "game_board.h", NULL },
+    .libs = (const char*[]) { "-lm", NULL },
+    .shared = true,
+};
+// The determinism test
+Target replay_target = {
+    .output = "cetris-replay",
+    .sources = (const char*[]) { "replay.c", "ai.c", "batch.c", "game.c", NULL },
+    .headers = (const char*[]) { "ai.h", "batch.h", "game.h", "game_board.h", NULL },
+    .libs = (const char*[]) { "-lm", "-lpthread", NULL },
+};
+#ifndef __APPLE__
+// The shared memory environment server and its client library (Linux only, they use futexes)
+Target envd_target = {
+    .output = "cetris-envd",
+    .sources = (const char*[]) { "envd.c", "cetris_envd.c", "cetris_env.c", "batch.c", "game.c", NULL },
+    .headers = (const char*[]) { "cetris_envd.h", "cetris_env.h", "batch.h", "game.h", "game_board.h", NULL },
+    .libs = (const char*[]) { "-lm", "-lrt", NULL },
+};
+Target envd_library_target = {
+    .output = "libcetris-envd.so",
+    .sources = (const char*[]) { "cetris_envd.c", NULL },
+    .headers = (const char*[]) { "cetris_envd.h", "cetris_env.h", NULL },
+    .libs = (const char*[]) { "-lrt", NULL },
+    .shared = true,
+};
+#endif
+
+/*
+    The game, static_raylib is the libraylib.a of the Static build on Linux
+*/
+Target game_target(BuildMode mode, const char* static_raylib)
+{
+    Target target = {
+        .output = "cetris",
+        .sources = game_sources,
+        .headers = game_headers,
+        .libs = raylib_libs,
+        .comp_database = true,
+    };
+    if (mode == BuildStatic) {
+#ifndef __APPLE__
+        raylib_static_libs[RAYLIB_STATIC_PATH] = static_raylib;
+#endif
+        target.libs = raylib_static_libs;
+    }
+    return target;
+}
+
+/*
+    Append the compiler and the flags of mode
+*/
+void cmd_append_cc(Cmd* cmd, BuildMode mode)
+{
+    cmd_append(cmd, "clang", "-Wall", "-Wextra", "-std=c23");
+    switch (mode) {
+    case BuildDebug:
+        cmd_append(cmd, "-ggdb");
+        break;
+    case BuildRelease:
+    case BuildStatic:
+        cmd_append(cmd, "-O3");
+        break;
+    case BuildInstrumented:
+        cmd_append(cmd, "-O3", "-fprofile-instr-generate");
+        break;
+    case BuildPgo:
+        cmd_append(cmd, "-O3", LTO_FLAGS, "-fprofile-instr-use=" PGO_PROFILE);
+        break;
+    }
+}
+
+/*
+    Path of the file that tells with which mode output was built
+*/
+const char* stamp_path(const char* output)
+{
+    return temp_sprintf("%s/%s", STAMP_DIR, output);
+}
+
+/*
+    True if target was built with another mode or it is older than one of its files
+*/
+bool Target_needs_rebuild(const Target* target, BuildMode mode)
+{
+    const char* path = stamp_path(target->output);
+    const char* name = build_mode_names[mode];
+    String_Builder stamp = { 0 };
+    bool same_mode = file_exists(path) == 1 && read_entire_file(path, &stamp) && stamp.count == strlen(name) && memcmp(stamp.items, name, stamp.count) == 0;
+    sb_free(stamp);
+    if (!same_mode) {
+        return true;
+    }
+
+    File_Paths inputs = { 0 };
+    da_append(&inputs, "nob.c");
+    for (const char** source = target->sources; *source != NULL; ++source) {
+        da_append(&inputs, *source);
+    }
+    for (const char** header = target->headers; *header != NULL; ++header) {
+        da_append(&inputs, *header);
+    }
+    // Errors (a missing file) rebuild too, the compiler tells what is wrong
+    bool rebuild = needs_rebuild(target->output, inputs.items, inputs.count) != 0;
+    da_free(inputs);
+    return rebuild;
+}
+
+/*
+    Build the outdated targets in parallel, one compile per core. The stamps are written
+    only if all the builds succeed
+*/
+bool build_targets(const Target* targets, size_t count, BuildMode mode)
+{
+    if (!mkdir_if_not_exists(STAMP_DIR))
+        return false;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t jobs = cores > 0 ? (size_t)cores : 1;
+    Cmd cmd = { 0 };
+    Procs procs = { 0 };
+    bool* started = calloc(count, sizeof(bool));
+    bool ok = started != NULL;
+
+    for (size_t i = 0; i < count && ok; ++i) {
+        const Target* target = &targets[i];
+        if (!Target_needs_rebuild(target, mode)) {
+            nob_log(INFO, "%s is up to date", target->output);
+            continue;
+        }
+
+        if (target->comp_database && (mode == BuildDebug || mode == BuildRelease || mode == BuildStatic)) {
+            cmd_append(&cmd, GEN_COMP_DATABASE);
+        }
+        cmd_append_cc(&cmd, mode);
+        if (target->shared) {
+            cmd_append(&cmd, "-shared", "-fPIC");
+        }
+        cmd_append(&cmd, "-o", target->output);
+        for (const char** source = target->sources; *source != NULL; ++source) {
+            cmd_append(&cmd, *source);
+        }
+        for (const char** lib = target->libs; *lib != NULL; ++lib) {
+            cmd_append(&cmd, *lib);
+        }
+
+        Proc proc = cmd_run_async_and_reset(&cmd);
+        ok = proc != INVALID_PROC && procs_append_with_flush(&procs, proc, jobs);
+        started[i] = true;
+    }
+    ok = procs_wait_and_reset(&procs) && ok;
+
+    const char* name = build_mode_names[mode];
+    for (size_t i = 0; i < count && ok; ++i) {
+        if (started[i]) {
+            ok = write_entire_file(stamp_path(targets[i].output), name, strlen(name));
+        }
+    }
+
+    free(started);
+    cmd_free(cmd);
+    da_free(procs);
+    return ok;
+}
+
+/*
+    The game and every headless program
+*/
+bool build_all(BuildMode mode)
+{
+    Target targets[] = {
+        game_target(mode, NULL),
+        tournament_target,
+        bot_target,
+        library_target,
+        replay_target,
+#ifndef __APPLE__
+        envd_target,
+        envd_library_target,
+#endif
+    };
+    return build_targets(targets, ARRAY_LEN(targets), mode);
+}
+
+/*
+    Build cetris-replay and replay the golden corpus with it: every change to the game core
+    must give the same state after every lock, and GameBatch must play as Game. Then the
+    same tournament runs on 1 and 4 threads: the results of every game must not depend on
+    the threads
+*/
+bool run_tests(Cmd* cmd)
+{
+    Target targets[] = { replay_target, tournament_target };
+    if (!build_targets(targets, ARRAY_LEN(targets), BuildRelease))
+        return false;
+
+    cmd_append(cmd, "./cetris-replay", "check", "tests/golden.replay");
+    if (!cmd_run_sync_and_reset(cmd))
+        return false;
+    cmd_append(cmd, "./cetris-replay", "batch", TEST_BATCH_STEPS);
+    if (!cmd_run_sync_and_reset(cmd))
+        return false;
+
+    if (!mkdir_if_not_exists(TEST_DIR))
+        return false;
+    const char* threads[] = { "1", "4" };
+    String_Builder results[ARRAY_LEN(threads)] = { 0 };
+    for (size_t i = 0; i < ARRAY_LEN(threads); ++i) {
+        const char* csv = temp_sprintf("%s/tournament-j%s.csv", TEST_DIR, threads[i]);
+        cmd_append(cmd, "./cetris-tournament", TEST_TOURNAMENT, "-j", threads[i], "-c", csv, "-o", "/dev/null");
+        if (!cmd_run_sync_and_reset(cmd) || !read_entire_file(csv, &results[i]))
+            return false;
+    }
+    bool same = results[0].count == results[1].count && memcmp(results[0].items, results[1].items, results[0].count) == 0;
+    for (size_t i = 0; i < ARRAY_LEN(threads); ++i) {
+        sb_free(results[i]);
+    }
+    if (!same) {
+        nob_log(ERROR, "the tournament results depend on the number of threads (see %s)", TEST_DIR);
+        return false;
+    }
+    nob_log(INFO, "tournament results on 1 and 4 threads: OK");
+    return true;
+}
+
+/*
+    Best wall time of PGO_RUNS runs of cmd, in seconds (negative if a run fails)
+*/
+double benchmark(Cmd* cmd)
+{
+    double best = -1.0;
+    for (int i = 0; i < PGO_RUNS; ++i) {
+        // The reports of the programs are not interesting here
+        Fd null = fd_open_for_write("/dev/null");
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool ok = cmd_run_sync_redirect(*cmd, (Cmd_Redirect) { .fdout = &null });
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        fd_close(null);
+        if (!ok) {
+            best = -1.0;
+            break;
+        }
+        double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    cmd->count = 0;
+    return best;
+}
+
+/*
+    Profile guided build of the headless programs (what the simulation servers run):
+    1. Release build, kept in PGO_DIR to compare with
+    2. instrumented build, trained with AI self play and the golden replays
+    3. profiles merged and everything rebuilt with the profile and link time optimization
+    4. the golden replays must still match, then both builds are timed on the same
+       workload and the report is written to PGO_DIR/report.txt
+*/
+bool build_pgo(Cmd* cmd)
+{
+    if (!mkdir_if_not_exists(PGO_DIR))
+        return false;
+    Target trained[] = { tournament_target, replay_target };
+
+    // 1. Release
+    if (!build_targets(trained, ARRAY_LEN(trained), BuildRelease))
+        return false;
+    if (!copy_file("cetris-tournament", PGO_DIR "/cetris-tournament-release") || !copy_file("cetris-replay", PGO_DIR "/cetris-replay-release"))
+        return false;
+
+    // 2. Instrumented and trained
+    if (!build_targets(trained, ARRAY_LEN(trained), BuildInstrumented))
+        return false;
+    setenv("LLVM_PROFILE_FILE", PGO_DIR "/tournament.profraw", 1);
+    cmd_append(cmd, "./cetris-tournament", PGO_TRAIN_TOURNAMENT);
+    if (!cmd_run_sync_and_reset(cmd))
+        return false;
+    setenv("LLVM_PROFILE_FILE", PGO_DIR "/replay.profraw", 1);
+    cmd_append(cmd, "./cetris-replay", "check", "tests/golden.replay");
+    if (!cmd_run_sync_and_reset(cmd))
+        return false;
+    cmd_append(cmd, "./cetris-replay", "batch", TEST_BATCH_STEPS);
+    if (!cmd_run_sync_and_reset(cmd))
+        return false;
+    unsetenv("LLVM_PROFILE_FILE");
+
+    // 3. Merged profile and optimized build: a new profile rebuilds everything, even when
+    //    the sources did not change
+    cmd_append(cmd, LLVM_PROFDATA, "merge", "-o", PGO_PROFILE, PGO_DIR "/tournament.profraw", PGO_DIR "/replay.profraw");
+    if (!cmd_run_sync_and_reset(cmd))
+        return false;
+    Target optimized[] = {
+        tournament_target,
+        bot_target,
+        library_target,
+        replay_target,
+#ifndef __APPLE__
+        envd_target,
+        envd_library_target,
+#endif
+    };
+    for (size_t i = 0; i < ARRAY_LEN(optimized); ++i) {
+        if (file_exists(stamp_path(optimized[i].output)) == 1 && !delete_file(stamp_path(optimized[i].output)))
+            return false;
+    }
+    if (!build_targets(optimized, ARRAY_LEN(optimized), BuildPgo))
+        return false;
+
+    // 4. Same behaviour, then the comparison
+    cmd_append(cmd, "./cetris-replay", "check", "tests/golden.replay");
+    if (!cmd_run_sync_and_reset(cmd)) {
+        nob_log(ERROR, "the PGO build does not replay the golden corpus");
+        return false;
+    }
+
+    const char* names[] = { "tournament", "replay" };
+    double times[2][2];
+    cmd_append(cmd, PGO_DIR "/cetris-tournament-release", PGO_BENCH_TOURNAMENT);
+    times[0][0] = benchmark(cmd);
+    cmd_append(cmd, "./cetris-tournament", PGO_BENCH_TOURNAMENT);
+    times[0][1] = benchmark(cmd);
+    cmd_append(cmd, PGO_DIR "/cetris-replay-release", "check", "tests/golden.replay", "-j", "1");
+    times[1][0] = benchmark(cmd);
+    cmd_append(cmd, "./cetris-replay", "check", "tests/golden.replay", "-j", "1");
+    times[1][1] = benchmark(cmd);
+
+    String_Builder report = { 0 };
+    sb_appendf(&report, "%-12s %12s %12s %9s\n", "workload", "release (s)", "pgo+lto (s)", "speedup");
+    for (int i = 0; i < 2; ++i) {
+        if (times[i][0] <= 0.0 || times[i][1] <= 0.0) {
+            nob_log(ERROR, "the %s benchmark failed", names[i]);
+            return false;
+        }
+        sb_appendf(&report, "%-12s %12.3f %12.3f %8.1f%%\n", names[i], times[i][0], times[i][1], (times[i][0] / times[i][1] - 1.0) * 100.0);
+    }
+    printf("%.*s", (int)report.count, report.items);
+    bool written = write_entire_file(PGO_DIR "/report.txt", report.items, report.count);
+    sb_free(report);
+    return written;
+}
+
 int main(int argc, char** argv)
 {
     NOB_GO_REBUILD_URSELF(argc, argv);
@@ -23,128 +492,53 @@ int main(int argc, char** argv)
 #ifdef __APPLE__
     if (argc == 2) {
         if (strcmp(argv[1], "Debug") == 0) {
-            cmd_append(&cmd,
-                GEN_COMP_DATABASE,
-                "clang",
-                "-Wall",
-                "-Wextra",
-                "-ggdb",
-                "-std=c23",
-                "-I/opt/homebrew/include/",
-                "-L/opt/homebrew/lib",
-                "-lraylib",
-                "-Wl,-rpath,/opt/homebrew/lib",
-                "-o",
-                "cetris",
-                "main.c");
-            if (!cmd_run_sync_and_reset(&cmd))
+            if (!build_all(BuildDebug))
                 return 1;
         } else if (strcmp(argv[1], "Release") == 0) {
-            cmd_append(&cmd,
-                GEN_COMP_DATABASE,
-                "clang",
-                "-Wall",
-                "-std=c23",
-                "-O3",
-                "-I/opt/homebrew/include/",
-                "-L/opt/homebrew/lib",
-                "-lraylib",
-                "-Wl,-rpath,/opt/homebrew/lib",
-                "-o",
-                "cetris",
-                "main.c");
-            if (!cmd_run_sync_and_reset(&cmd))
+            if (!build_all(BuildRelease))
                 return 1;
         } else if (strcmp(argv[1], "Static") == 0) {
-            cmd_append(&cmd,
-                GEN_COMP_DATABASE,
-                "clang",
-                "-Wall",
-                "-std=c23",
-                "-O3",
-                "-I/opt/homebrew/include/",
-                "-isysroot",
-                "/Library/Developer/CommandLineTools/SDKs/MacOSX.sdk",
-                "-framework",
-                "Cocoa",
-                "-framework",
-                "OpenGL",
-                "-framework",
-                "IOKit",
-                "-framework",
-                "CoreAudio",
-                "-framework",
-                "CoreVideo",
-                "-lm",
-                "-lpthread",
-                "-o",
-                "cetris",
-                "main.c",
-                "/opt/homebrew/lib/libraylib.a");
-            if (!cmd_run_sync_and_reset(&cmd))
+            Target game = game_target(BuildStatic, NULL);
+            if (!build_targets(&game, 1, BuildStatic))
+                return 1;
+        } else if (strcmp(argv[1], "Test") == 0) {
+            if (!run_tests(&cmd))
+                return 1;
+        } else if (strcmp(argv[1], "PGO") == 0) {
+            if (!build_pgo(&cmd))
                 return 1;
         } else {
-            printf("ERROR: Use [Debug|Release|Static]\n");
+            printf("ERROR: Use [Debug|Release|Static|Test|PGO]\n");
             return 1;
         }
     } else {
-        printf("ERROR: use 1 parameter [Debug|Release]\n");
+        printf("ERROR: use 1 parameter [Debug|Release|Static|Test|PGO]\n");
         return 1;
     }
 #else
     if (argc == 2 || argc == 3) {
         if (strcmp(argv[1], "Debug") == 0) {
-            cmd_append(&cmd,
-                GEN_COMP_DATABASE,
-                "clang",
-                "-Wall",
-                "-Wextra",
-                "-ggdb",
-                "-std=c23",
-                "-I/usr/include",
-                "-lraylib",
-                "-lm",
-                "-o",
-                "cetris",
-                "main.c");
-            if (!cmd_run_sync_and_reset(&cmd))
+            if (!build_all(BuildDebug))
                 return 1;
         } else if (strcmp(argv[1], "Release") == 0) {
-            cmd_append(&cmd,
-                GEN_COMP_DATABASE,
-                "clang",
-                "-Wall",
-                "-std=c23",
-                "-O3",
-                "-I/usr/include",
-                "-lraylib",
-                "-lm",
-                "-o",
-                "cetris",
-                "main.c");
-            if (!cmd_run_sync_and_reset(&cmd))
+            if (!build_all(BuildRelease))
                 return 1;
-        } else if (strcmp(argv[1], "Static") == 0) {
-            cmd_append(&cmd,
-                GEN_COMP_DATABASE,
-                "clang",
-                "-Wall",
-                "-std=c23",
-                "-O3",
-                "-I/usr/include",
-                "-lm",
-                "-o",
-                "cetris",
-                "main.c",
-                argv[2]);
-            if (!cmd_run_sync_and_reset(&cmd))
+        } else if (strcmp(argv[1], "Static") == 0 && argc == 3) {
+            Target game = game_target(BuildStatic, argv[2]);
+            if (!build_targets(&game, 1, BuildStatic))
+                return 1;
+        } else if (strcmp(argv[1], "Test") == 0) {
+            if (!run_tests(&cmd))
+                return 1;
+        } else if (strcmp(argv[1], "PGO") == 0) {
+            if (!build_pgo(&cmd))
                 return 1;
         } else {
-            printf("ERROR: Use [Debug|Release|Static + (path-to-static-lib)]\n");
+            printf("ERROR: Use [Debug|Release|Static + (path-to-static-lib)|Test|PGO]\n");
             return 1;
         }
     } else {
-        printf("ERROR: use 1 or 2(for static) parameter [Debug|Release|Static+(path-to-static-lib)]\n");
+        printf("ERROR: use 1 or 2(for static) parameter [Debug|Release|Static+(path-to-static-lib)|Test|PGO]\n");
         return 1;
     }
 #endif
@@ -154,9 +548,10 @@ int main(int argc, char** argv)
         "emcc",
         "-o",
         "cetris.html",
-        "main.c",
+        GAME_SOURCES,
         "-std=c23",
         "-Os",
+        "-msimd128",
         "-Wall",
         "raylib-5.5/build/raylib/libraylib.a",
         "-I./raylib-5.5/build/raylib/include",
@@ -0,0 +1,133 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "particles.h"
+
+/*
+    Every array of the pool starts on its own cache line
+*/
+#define PARTICLES_ALIGN 64
+#define PARTICLES_ALIGN_UP(size) (((size) + PARTICLES_ALIGN - 1) & ~(size_t)(PARTICLES_ALIGN - 1))
+
+/*
+    Uniform float in [0, 1) from 16 bits of a random number, starting at bit shift
+*/
+#define PARTICLES_FRACTION(random, shift) ((float)(((random) >> (shift)) & 0xFFFF) * (1.0f / 65536.0f))
+
+bool ParticlePool_init(ParticlePool* pool, int capacity, uint64_t seed)
+{
+    assert(capacity > 0);
+    memset(pool, 0, sizeof(*pool));
+    pool->capacity = capacity;
+    pool->rng = Rng_seed(seed);
+
+    size_t n = (size_t)capacity;
+    size_t sizes[] = {
+        n * sizeof(float), // x
+        n * sizeof(float), // y
+        n * sizeof(float), // vx
+        n * sizeof(float), // vy
+        n * sizeof(float), // life
+        n * sizeof(uint32_t), // color
+    };
+
+    size_t total = 0;
+    for (int i = 0; i < ARRAY_LEN_INT(sizes); ++i) {
+        total += PARTICLES_ALIGN_UP(sizes[i]);
+    }
+    pool->memory = aligned_alloc(PARTICLES_ALIGN, total);
+    if (pool->memory == nullptr) {
+        return false;
+    }
+    // Touch the pages now, not in the frame of the first tetris
+    memset(pool->memory, 0, total);
+
+    void** arrays[] = {
+        (void**)&pool->x,
+        (void**)&pool->y,
+        (void**)&pool->vx,
+        (void**)&pool->vy,
+        (void**)&pool->life,
+        (void**)&pool->color,
+    };
+    static_assert(ARRAY_LEN_INT(arrays) == ARRAY_LEN_INT(sizes), "One size for every array");
+
+    uint8_t* next = pool->memory;
+    for (int i = 0; i < ARRAY_LEN_INT(arrays); ++i) {
+        *arrays[i] = next;
+        next += PARTICLES_ALIGN_UP(sizes[i]);
+    }
+    return true;
+}
+
+void ParticlePool_free(ParticlePool* pool)
+{
+    free(pool->memory);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void ParticlePool_clear(ParticlePool* pool)
+{
+    pool->count = 0;
+}
+
+int ParticlePool_emit(ParticlePool* pool, float x, float y, float width, float height, int count, uint32_t color, float speed, float life)
+{
+    if (count > pool->capacity - pool->count) {
+        count = pool->capacity - pool->count;
+    }
+
+    // 16 bits of randomness are plenty for pixels: one number gives the 4 coordinates
+    for (int i = pool->count; i < pool->count + count; ++i) {
+        uint64_t random = Rng_next(&pool->rng);
+        pool->x[i] = x + PARTICLES_FRACTION(random, 0) * width;
+        pool->y[i] = y + PARTICLES_FRACTION(random, 16) * height;
+        pool->vx[i] = (PARTICLES_FRACTION(random, 32) * 2.0f - 1.0f) * speed;
+        pool->vy[i] = (PARTICLES_FRACTION(random, 48) * 2.0f - 1.0f) * speed;
+        pool->color[i] = color;
+    }
+    // At least half of life, so a burst does not vanish all at once
+    for (int i = pool->count; i < pool->count + count; i += 4) {
+        uint64_t random = Rng_next(&pool->rng);
+        for (int j = i; j < i + 4 && j < pool->count + count; ++j) {
+            pool->life[j] = life * (0.5f + 0.5f * PARTICLES_FRACTION(random, 16 * (j - i)));
+        }
+    }
+    pool->count += count;
+
+    return count;
+}
+
+void ParticlePool_update(ParticlePool* pool, float delta_time, float gravity)
+{
+    int count = pool->count;
+    float* restrict x = pool->x;
+    float* restrict y = pool->y;
+    float* restrict vx = pool->vx;
+    float* restrict vy = pool->vy;
+    float* restrict life = pool->life;
+
+    // Independent lanes and no branches: this is the vectorized part
+    for (int i = 0; i < count; ++i) {
+        vy[i] += gravity * delta_time;
+        x[i] += vx[i] * delta_time;
+        y[i] += vy[i] * delta_time;
+        life[i] -= delta_time;
+    }
+
+    for (int i = 0; i < count;) {
+        if (life[i] > 0.0f) {
+            i += 1;
+            continue;
+        }
+        count -= 1;
+        x[i] = x[count];
+        y[i] = y[count];
+        vx[i] = vx[count];
+        vy[i] = vy[count];
+        life[i] = life[count];
+        pool->color[i] = pool->color[count];
+    }
+    pool->count = count;
+}
@@ -0,0 +1,56 @@
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+    A fixed pool of particles for the effects (line clears, level ups). The memory is
+    allocated once by ParticlePool_init, emitting only fills free slots (a full pool drops
+    the new particles) and a dead particle is replaced by the last one, so the live ones
+    are always [0, count).
+
+    Everything is stored as structure of arrays, so the update is a straight loop over
+    contiguous floats that the compiler turns into vector instructions (SSE/NEON on the
+    desktop, simd128 on the web).
+
+    Positions are in pixels and the pool has its own Rng: effects never touch the random
+    state of a Game.
+*/
+
+#define PARTICLES_CAPACITY 32768
+
+typedef struct {
+    int count;
+    int capacity;
+    Rng rng;
+
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* life; // seconds left
+    uint32_t* color; // 0xRRGGBBAA
+
+    void* memory;
+} ParticlePool;
+
+bool ParticlePool_init(ParticlePool* pool, int capacity, uint64_t seed);
+void ParticlePool_free(ParticlePool* pool);
+void ParticlePool_clear(ParticlePool* pool);
+
+/*
+    Emit count particles from random points of the rectangle (x, y, width, height), going
+    in random directions up to speed pixels per second and living up to life seconds.
+    Return how many fit in the pool
+*/
+int ParticlePool_emit(ParticlePool* pool, float x, float y, float width, float height, int count, uint32_t color, float speed, float life);
+
+/*
+    Move the particles by delta_time, with gravity in pixels per second squared, and
+    remove the dead ones
+*/
+void ParticlePool_update(ParticlePool* pool, float delta_time, float gravity);
+
+#endif // PARTICLES_H_
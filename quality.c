@@ -0,0 +1,207 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <rlgl.h>
+
+#include "quality.h"
+
+/*
+    Go to tier and measure it from scratch
+*/
+void RenderQuality_set(RenderQuality* quality, QualityTier tier);
+
+/*
+    Pattern of a square for liquid_square_texture.glsl, what liquid_square.glsl computes
+    without the time:
+    - r: glow of the cell, smoothstep(0.15, 0.0, distance from its center)
+    - g: phase of the pulse of the cell, in turns
+    - b: phase of the sparkle, in turns
+*/
+Texture2D RenderQuality_bake_pattern(void);
+
+/*
+    sin * 0.5 + 0.5 over one turn of x in the red and of y in the green, so the pulse and
+    the sparkle are read with one fetch
+*/
+Texture2D RenderQuality_bake_wave(void);
+
+/*
+    Upload the pixels as a RGBA texture
+*/
+Texture2D texture_from_pixels(Color* pixels, int width, int height, int filter);
+
+void RenderQuality_init(RenderQuality* quality, QualityTier best, bool automatic)
+{
+#ifdef __EMSCRIPTEN__
+    quality->shaders[QualityFull] = LoadShader("resources/shaders/liquid_square_vertex.glsl", "resources/shaders/liquid_square_web.glsl");
+    quality->shaders[QualityLut] = LoadShader("resources/shaders/liquid_square_vertex.glsl", "resources/shaders/liquid_square_lut_web.glsl");
+    quality->shaders[QualityTexture] = LoadShader("resources/shaders/liquid_square_vertex.glsl", "resources/shaders/liquid_square_texture_web.glsl");
+#else
+    quality->shaders[QualityFull] = LoadShader(nullptr, "resources/shaders/liquid_square.glsl");
+    quality->shaders[QualityLut] = LoadShader(nullptr, "resources/shaders/liquid_square_lut.glsl");
+    quality->shaders[QualityTexture] = LoadShader(nullptr, "resources/shaders/liquid_square_texture.glsl");
+#endif
+    quality->shaders[QualityFlat] = (Shader) { .id = rlGetShaderIdDefault(), .locs = rlGetShaderLocsDefault() };
+
+    // Uniforms keep their value: the table is uploaded once
+    float wave[QUALITY_WAVE_SIZE];
+    for (int i = 0; i < QUALITY_WAVE_SIZE; ++i) {
+        wave[i] = sinf(2.0f * PI * (float)i / QUALITY_WAVE_SIZE) * 0.5f + 0.5f;
+    }
+    Shader lut = quality->shaders[QualityLut];
+    SetShaderValueV(lut, GetShaderLocation(lut, "wave"), wave, SHADER_UNIFORM_FLOAT, QUALITY_WAVE_SIZE);
+
+    quality->pattern = RenderQuality_bake_pattern();
+    quality->wave = RenderQuality_bake_wave();
+
+    quality->best = best;
+    quality->automatic = automatic;
+    quality->probe_delay = QUALITY_PROBE_DELAY;
+    RenderQuality_set(quality, best);
+}
+
+void RenderQuality_free(RenderQuality* quality)
+{
+    // The default shader belongs to raylib
+    UnloadShader(quality->shaders[QualityFull]);
+    UnloadShader(quality->shaders[QualityLut]);
+    UnloadShader(quality->shaders[QualityTexture]);
+    UnloadTexture(quality->pattern);
+    UnloadTexture(quality->wave);
+}
+
+Shader RenderQuality_shader(const RenderQuality* quality)
+{
+    return quality->shaders[quality->tier];
+}
+
+void RenderQuality_begin(const RenderQuality* quality)
+{
+    Shader shader = RenderQuality_shader(quality);
+    BeginShaderMode(shader);
+    if (quality->tier == QualityTexture) {
+        SetShaderValueTexture(shader, GetShaderLocation(shader, "pattern"), quality->pattern);
+        SetShaderValueTexture(shader, GetShaderLocation(shader, "wave"), quality->wave);
+    }
+}
+
+void RenderQuality_update(RenderQuality* quality, float frame_time)
+{
+    if (!quality->automatic || frame_time > QUALITY_HITCH) {
+        return;
+    }
+
+    quality->average += (frame_time - quality->average) * QUALITY_AVERAGE_WEIGHT;
+    bool slow = quality->average > QUALITY_FRAME_BUDGET * QUALITY_SLOW_FACTOR;
+    quality->slow_frames = slow ? quality->slow_frames + 1 : 0;
+    quality->stable_time = slow ? 0.0f : quality->stable_time + frame_time;
+    if (quality->probe_time >= 0.0f) {
+        quality->probe_time += frame_time;
+    }
+
+    if (quality->slow_frames >= QUALITY_SLOW_FRAMES && quality->tier < QualityFlat) {
+        if (quality->probe_time >= 0.0f && quality->probe_time < QUALITY_PROBE_TIME) {
+            quality->probe_delay = fminf(quality->probe_delay * 2.0f, QUALITY_PROBE_DELAY_MAX);
+        }
+        RenderQuality_set(quality, (QualityTier)(quality->tier + 1));
+    } else if (quality->tier > quality->best && quality->stable_time >= quality->probe_delay) {
+        RenderQuality_set(quality, (QualityTier)(quality->tier - 1));
+        quality->probe_time = 0.0f;
+    }
+}
+
+void RenderQuality_set(RenderQuality* quality, QualityTier tier)
+{
+    quality->tier = tier;
+    quality->average = QUALITY_FRAME_BUDGET;
+    quality->slow_frames = 0;
+    quality->stable_time = 0.0f;
+    quality->probe_time = -1.0f;
+}
+
+const char* QualityTier_name(QualityTier tier)
+{
+    switch (tier) {
+    case QualityFull:
+        return "full";
+    case QualityLut:
+        return "lut";
+    case QualityTexture:
+        return "texture";
+    case QualityFlat:
+        return "flat";
+    case QualityCount:
+        break;
+    }
+    return "?";
+}
+
+Texture2D RenderQuality_bake_pattern(void)
+{
+    const float turn = 2.0f * PI;
+    Color* pixels = malloc(QUALITY_PATTERN_SIZE * QUALITY_PATTERN_SIZE * sizeof(Color));
+
+    for (int y = 0; y < QUALITY_PATTERN_SIZE; ++y) {
+        for (int x = 0; x < QUALITY_PATTERN_SIZE; ++x) {
+            // At the center of the pixel, as the fragment shader
+            float grid_x = ((float)x + 0.5f) * QUALITY_PATTERN_CELLS / QUALITY_PATTERN_SIZE;
+            float grid_y = ((float)y + 0.5f) * QUALITY_PATTERN_CELLS / QUALITY_PATTERN_SIZE;
+            float cell_x = grid_x - floorf(grid_x) - 0.5f;
+            float cell_y = grid_y - floorf(grid_y) - 0.5f;
+
+            float glow = 1.0f - fminf(sqrtf(cell_x * cell_x + cell_y * cell_y) / 0.15f, 1.0f);
+            glow = glow * glow * (3.0f - 2.0f * glow);
+            float pulse = (floorf(grid_x) + floorf(grid_y)) / turn;
+            float sparkle = (grid_x + grid_y) * 10.0f / turn;
+
+            pixels[y * QUALITY_PATTERN_SIZE + x] = (Color) {
+                .r = (unsigned char)(glow * 255.0f + 0.5f),
+                .g = (unsigned char)((pulse - floorf(pulse)) * 255.0f + 0.5f),
+                .b = (unsigned char)((sparkle - floorf(sparkle)) * 255.0f + 0.5f),
+                .a = 255,
+            };
+        }
+    }
+
+    // The phases jump from 1 to 0: filtering would blend them into a wrong phase
+    return texture_from_pixels(pixels, QUALITY_PATTERN_SIZE, QUALITY_PATTERN_SIZE, TEXTURE_FILTER_POINT);
+}
+
+Texture2D RenderQuality_bake_wave(void)
+{
+    Color* pixels = malloc(QUALITY_WAVE_SIZE * QUALITY_WAVE_SIZE * sizeof(Color));
+
+    for (int y = 0; y < QUALITY_WAVE_SIZE; ++y) {
+        for (int x = 0; x < QUALITY_WAVE_SIZE; ++x) {
+            // Pixel i is sampled at its center, (i + 0.5) / size of a turn
+            float wave_x = sinf(2.0f * PI * ((float)x + 0.5f) / QUALITY_WAVE_SIZE) * 0.5f + 0.5f;
+            float wave_y = sinf(2.0f * PI * ((float)y + 0.5f) / QUALITY_WAVE_SIZE) * 0.5f + 0.5f;
+            pixels[y * QUALITY_WAVE_SIZE + x] = (Color) {
+                .r = (unsigned char)(wave_x * 255.0f + 0.5f),
+                .g = (unsigned char)(wave_y * 255.0f + 0.5f),
+                .b = 0,
+                .a = 255,
+            };
+        }
+    }
+
+    // Linear and repeated: the last pixel blends into the first one, a turn later
+    return texture_from_pixels(pixels, QUALITY_WAVE_SIZE, QUALITY_WAVE_SIZE, TEXTURE_FILTER_BILINEAR);
+}
+
+Texture2D texture_from_pixels(Color* pixels, int width, int height, int filter)
+{
+    Image image = {
+        .data = pixels,
+        .width = width,
+        .height = height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    Texture2D texture = LoadTextureFromImage(image);
+    SetTextureFilter(texture, filter);
+    SetTextureWrap(texture, TEXTURE_WRAP_REPEAT);
+    free(pixels);
+
+    return texture;
+}
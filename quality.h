@@ -0,0 +1,89 @@
+#ifndef QUALITY_H_
+#define QUALITY_H_
+
+#include <raylib.h>
+
+/*
+    Shader quality of the squares, from the most expensive:
+    - QualityFull: the procedural liquid shader (sin, length and smoothstep per fragment)
+    - QualityLut: the same look, the waves are read from a table filled once and the glow
+      is a parabola of the squared distance
+    - QualityTexture: the same look baked in two textures made at startup, a pattern with the
+      glow and the phase of the waves of every pixel and a table of the waves: two texture
+      fetches per fragment and no math
+    - QualityFlat: no effect, the default shader of raylib
+
+    In automatic mode a governor watches the frame time: when the average stays over the
+    budget it goes one tier down. With vsync a fast frame waits anyway, so the headroom
+    cannot be measured: after some time within budget it tries the tier above, and a try
+    that fails right away waits twice as long before the next one.
+*/
+
+#define QUALITY_FRAME_BUDGET (1.0f / 60.0f)
+#define QUALITY_SLOW_FACTOR 1.2f // the average is slow over budget * factor (50 FPS)
+#define QUALITY_SLOW_FRAMES 30 // slow frames in a row before going down
+#define QUALITY_AVERAGE_WEIGHT 0.1f // of the last frame in the moving average
+#define QUALITY_HITCH 0.25f // longer frames (loading, resume from a pause) are not measured
+#define QUALITY_PROBE_DELAY 5.0f // seconds within budget before trying the tier above
+#define QUALITY_PROBE_DELAY_MAX 120.0f
+#define QUALITY_PROBE_TIME 2.0f // going down before this time after a try fails it
+#define QUALITY_WAVE_SIZE 64 // samples of the table of QualityLut, as in the shader
+#define QUALITY_PATTERN_SIZE 320 // pixels of the side of the pattern of QualityTexture
+#define QUALITY_PATTERN_CELLS 20 // glowing cells on the side of a square, as in the shaders
+
+// The web runs on integrated GPUs and software GL more often
+#ifdef __EMSCRIPTEN__
+#define QUALITY_DEFAULT QualityTexture
+#else
+#define QUALITY_DEFAULT QualityFull
+#endif
+
+typedef enum {
+    QualityFull,
+    QualityLut,
+    QualityTexture,
+    QualityFlat,
+    QualityCount
+} QualityTier;
+
+typedef struct {
+    Shader shaders[QualityCount];
+    Texture2D pattern; // of QualityTexture
+    Texture2D wave;
+    QualityTier tier;
+    QualityTier best; // the governor never goes above it
+    bool automatic;
+
+    // Governor
+    float average; // moving average of the frame time
+    int slow_frames;
+    float stable_time; // seconds within budget at this tier
+    float probe_delay;
+    float probe_time; // seconds since the last step up, negative if it is not a try
+} RenderQuality;
+
+/*
+    Load the shaders of every tier and start from best
+*/
+void RenderQuality_init(RenderQuality* quality, QualityTier best, bool automatic);
+void RenderQuality_free(RenderQuality* quality);
+
+/*
+    Shader of the current tier
+*/
+Shader RenderQuality_shader(const RenderQuality* quality);
+
+/*
+    BeginShaderMode with the shader of the current tier. raylib forgets the extra textures
+    of a shader after every batch, so they are bound again every time
+*/
+void RenderQuality_begin(const RenderQuality* quality);
+
+/*
+    Measure a frame of the game and change tier if needed. Does nothing if not automatic
+*/
+void RenderQuality_update(RenderQuality* quality, float frame_time);
+
+const char* QualityTier_name(QualityTier tier);
+
+#endif // QUALITY_H_
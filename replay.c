@@ -0,0 +1,771 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ai.h"
+#include "batch.h"
+#include "game.h"
+
+/*
+    cetris-replay: determinism regression test of the game core.
+
+    A corpus is a list of recorded games: seed, start level, randomizer and the inputs
+    (moves, rotations, hard drops and gravity ticks, as the player and the timer give them
+    to the game). After every lock the snapshot of the game is hashed: the corpus keeps the
+    low 16 bits of every hash, to tell which lock diverged, and a chain of all of them, to
+    never miss a divergence. `check` replays the corpus on every core and compares; `record`
+    plays new games with the AI and writes the corpus with the hashes of this build, the
+    golden values. `batch` steps GameBatch and as many Game with the same random actions and
+    compares them after every step: the batch must follow the rules of Game exactly.
+
+    File (little endian): "CETR", version, games, then every game:
+    seed u64, start level u8, randomizer u8, topped out u8, 0 u8, locks u32, input bytes u32,
+    chain u64, u16 per lock, the inputs two per byte (low nibble first, 0 is padding)
+*/
+
+#define REPLAY_MAGIC "CETR"
+#define REPLAY_VERSION 1
+#define REPLAY_GAME_HEADER 28
+#define REPLAY_SHOWN_FAILURES 10
+#define TT_LOG2_ENTRIES 16
+
+typedef enum {
+    ReplayNone, // padding of the last byte
+    ReplayLeft,
+    ReplayRight,
+    ReplayRotateLeft,
+    ReplayRotateRight,
+    ReplayHardDrop,
+    ReplayGravity, // the piece goes down by one row, or locks if it touches
+} ReplayInput;
+
+typedef struct {
+    uint64_t seed;
+    int start_level;
+    Randomizer randomizer;
+    bool topped_out;
+    int locks;
+    int input_bytes;
+    uint64_t chain;
+    const uint8_t* checks; // 2 bytes per lock
+    const uint8_t* inputs;
+} ReplayGame;
+
+typedef struct {
+    int lock; // first lock that diverged, -1 if the game matches
+    const char* reason;
+} ReplayResult;
+
+typedef struct {
+    const ReplayGame* games;
+    int count;
+    ReplayResult* results;
+    atomic_int next_game;
+    atomic_long locks;
+} ReplayCheck;
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+void usage(const char* program);
+
+/*
+    Apply one input to game. Return true if the active piece locked
+*/
+bool Replay_step(Game* game, ReplayInput input, int start_level);
+
+/*
+    Hash of the whole state of the game
+*/
+uint64_t Replay_hash(const Game* game);
+uint64_t Replay_chain(uint64_t chain, uint64_t hash);
+
+/*
+    Replay game from its inputs and compare every lock with the golden hashes
+*/
+ReplayResult ReplayGame_check(const ReplayGame* game);
+
+/*
+    Worker thread: take the next game index until there are no more games
+*/
+void* check_worker(void* arg);
+
+/*
+    Parse the corpus in data, games points into it. Return the number of games, -1 (and
+    games nullptr) if the file is not a valid corpus
+*/
+int Corpus_parse(const uint8_t* data, size_t size, ReplayGame** games);
+int check(const char* path, int threads);
+
+/*
+    Play a game with the AI and append it to out, with the golden hashes of this build.
+    Without ai the pieces go to random places, until the game tops out
+*/
+bool record_game(ByteBuffer* out, Ai* ai, uint64_t seed, int index, int max_pieces);
+
+/*
+    Record games games with the AI, then top_outs games with random placements
+*/
+int record(const char* path, int games, int top_outs, int max_pieces, uint64_t seed);
+
+/*
+    Apply action to game, then the gravity, as a step of GameBatch. Return true if the game
+    is over
+*/
+bool Batch_step_game(Game* game, Action action, int start_level);
+
+/*
+    First difference between game and the game index of batch, nullptr if they match
+*/
+const char* Batch_compare(const GameBatch* batch, int index, const Game* game, bool over);
+
+/*
+    Run games of every randomizer for steps steps of random actions in a GameBatch and
+    in Game, restarting the games that end with new seeds
+*/
+int batch_check(int steps, int games, uint64_t seed);
+
+bool ByteBuffer_append(ByteBuffer* buffer, const void* data, size_t size);
+bool ByteBuffer_append_le(ByteBuffer* buffer, uint64_t value, int bytes);
+uint64_t read_le(const uint8_t* data, int bytes);
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cores > 0 ? (int)cores : 1;
+    int games = 1024;
+    int max_pieces = 40;
+    int top_outs = 0;
+    uint64_t seed = 1;
+    for (int i = 3; i < argc; ++i) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 'j':
+            threads = atoi(value);
+            break;
+        case 'g':
+            games = atoi(value);
+            break;
+        case 'm':
+            max_pieces = atoi(value);
+            break;
+        case 't':
+            top_outs = atoi(value);
+            break;
+        case 's':
+            seed = strtoull(value, nullptr, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads <= 0 || games <= 0 || max_pieces <= 0 || top_outs < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "check") == 0) {
+        return check(argv[2], threads);
+    } else if (strcmp(argv[1], "record") == 0) {
+        return record(argv[2], games, top_outs, max_pieces, seed);
+    } else if (strcmp(argv[1], "batch") == 0 && atoi(argv[2]) > 0) {
+        return batch_check(atoi(argv[2]), games, seed);
+    }
+    usage(argv[0]);
+    return 1;
+}
+
+//              //
+//              //
+//  FUNCTIONS   //
+//              //
+//              //
+
+void usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s check <corpus> [-j <threads>]\n"
+        "       %s record <corpus> [-g <games>] [-m <pieces>] [-t <games>] [-s <seed>]\n"
+        "       %s batch <steps> [-g <games>] [-s <seed>]\n"
+        "  -j <threads>   worker threads (default: all cores)\n"
+        "  -g <games>     games to record, or of every randomizer in the batch (default 1024)\n"
+        "  -m <pieces>    stop a recorded game after this many pieces (default 40)\n"
+        "  -t <games>     then record games with random placements until they top out (default 0)\n"
+        "  -s <seed>      base seed of the recorded games (default 1)\n",
+        program, program, program);
+}
+
+bool Replay_step(Game* game, ReplayInput input, int start_level)
+{
+    switch (input) {
+    case ReplayNone:
+        break;
+    case ReplayLeft:
+        Game_move_active_piece(game, Left);
+        break;
+    case ReplayRight:
+        Game_move_active_piece(game, Right);
+        break;
+    case ReplayRotateLeft:
+        Game_rotate_active_piece(game, Left);
+        break;
+    case ReplayRotateRight:
+        Game_rotate_active_piece(game, Right);
+        break;
+    case ReplayHardDrop:
+        Game_hard_drop_active_piece(game);
+        break;
+    case ReplayGravity:
+        if (Game_gravity_active_piece(game)) {
+            Game_lock_active_piece(game, start_level, nullptr);
+            return true;
+        }
+        break;
+    }
+    return false;
+}
+
+uint64_t Replay_hash(const Game* game)
+{
+    GameSnapshot snapshot;
+    Game_snapshot(game, &snapshot);
+    return GameSnapshot_hash(&snapshot);
+}
+
+uint64_t Replay_chain(uint64_t chain, uint64_t hash)
+{
+    return (chain ^ hash) * 0x100000001b3u;
+}
+
+ReplayResult ReplayGame_check(const ReplayGame* replay)
+{
+    Game game = Game_init(replay->start_level, replay->seed, replay->randomizer);
+    uint64_t chain = 0;
+    int locks = 0;
+    bool topped_out = false;
+
+    for (int i = 0; i < replay->input_bytes * 2; ++i) {
+        ReplayInput input = (ReplayInput)((replay->inputs[i / 2] >> (i % 2 * 4)) & 0xF);
+        if (input > ReplayGravity) {
+            return (ReplayResult) { locks, "unknown input" };
+        }
+        if (input == ReplayNone) {
+            continue;
+        }
+        if (topped_out) {
+            return (ReplayResult) { locks, "inputs after the game over" };
+        }
+        if (!Replay_step(&game, input, replay->start_level)) {
+            continue;
+        }
+
+        if (locks == replay->locks) {
+            return (ReplayResult) { locks, "more locks than recorded" };
+        }
+        uint64_t hash = Replay_hash(&game);
+        if ((uint16_t)hash != (uint16_t)read_le(replay->checks + 2 * locks, 2)) {
+            return (ReplayResult) { locks, "state hash" };
+        }
+        chain = Replay_chain(chain, hash);
+        locks += 1;
+        topped_out = Game_check_game_over(&game);
+    }
+
+    if (locks != replay->locks) {
+        return (ReplayResult) { locks, "fewer locks than recorded" };
+    }
+    if (chain != replay->chain) {
+        return (ReplayResult) { locks, "hash chain" };
+    }
+    if (topped_out != replay->topped_out) {
+        return (ReplayResult) { locks, "game over" };
+    }
+    return (ReplayResult) { -1, nullptr };
+}
+
+void* check_worker(void* arg)
+{
+    ReplayCheck* replay = arg;
+    long locks = 0;
+
+    for (;;) {
+        int index = atomic_fetch_add_explicit(&replay->next_game, 1, memory_order_relaxed);
+        if (index >= replay->count) {
+            break;
+        }
+        replay->results[index] = ReplayGame_check(&replay->games[index]);
+        locks += replay->results[index].lock < 0 ? replay->games[index].locks : replay->results[index].lock;
+    }
+
+    atomic_fetch_add_explicit(&replay->locks, locks, memory_order_relaxed);
+    return nullptr;
+}
+
+int Corpus_parse(const uint8_t* data, size_t size, ReplayGame** games)
+{
+    *games = nullptr;
+    if (size < 12 || memcmp(data, REPLAY_MAGIC, 4) != 0 || read_le(data + 4, 4) != REPLAY_VERSION) {
+        return -1;
+    }
+    // Every game takes at least its header: a bigger count is a corrupt file, not an allocation
+    uint64_t count = read_le(data + 8, 4);
+    if (count > (size - 12) / REPLAY_GAME_HEADER) {
+        return -1;
+    }
+    *games = calloc((size_t)count + 1, sizeof(ReplayGame));
+    if (*games == nullptr) {
+        return -1;
+    }
+
+    size_t offset = 12;
+    uint64_t parsed = 0;
+    for (; parsed < count; ++parsed) {
+        if (size - offset < REPLAY_GAME_HEADER) {
+            break;
+        }
+        const uint8_t* header = data + offset;
+        ReplayGame* game = &(*games)[parsed];
+        *game = (ReplayGame) {
+            .seed = read_le(header, 8),
+            .start_level = header[8],
+            .randomizer = (Randomizer)header[9],
+            .topped_out = header[10] != 0,
+            .chain = read_le(header + 20, 8),
+        };
+        offset += REPLAY_GAME_HEADER;
+
+        uint64_t locks = read_le(header + 12, 4);
+        uint64_t input_bytes = read_le(header + 16, 4);
+        if (game->start_level > 9 || game->randomizer > Nes || locks > INT32_MAX || input_bytes > INT32_MAX / 2
+            || 2 * locks + input_bytes > size - offset) {
+            break;
+        }
+        game->locks = (int)locks;
+        game->input_bytes = (int)input_bytes;
+        game->checks = data + offset;
+        game->inputs = data + offset + 2 * locks;
+        offset += 2 * locks + input_bytes;
+    }
+
+    if (parsed != count || offset != size) {
+        free(*games);
+        *games = nullptr;
+        return -1;
+    }
+    return (int)count;
+}
+
+int check(const char* path, int threads)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "ERROR: cannot open %s\n", path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = malloc(size > 0 ? (size_t)size : 1);
+    if (data == nullptr || size <= 0 || fread(data, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "ERROR: cannot read %s\n", path);
+        fclose(file);
+        free(data);
+        return 1;
+    }
+    fclose(file);
+
+    ReplayGame* games = nullptr;
+    int count = Corpus_parse(data, (size_t)size, &games);
+    if (count < 0) {
+        fprintf(stderr, "ERROR: %s is not a valid corpus\n", path);
+        free(data);
+        return 1;
+    }
+
+    ReplayCheck replay = {
+        .games = games,
+        .count = count,
+        .results = calloc((size_t)count + 1, sizeof(ReplayResult)),
+    };
+    pthread_t* workers = calloc((size_t)threads, sizeof(pthread_t));
+    if (replay.results == nullptr || workers == nullptr) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        free(workers);
+        free(replay.results);
+        free(games);
+        free(data);
+        return 1;
+    }
+    atomic_init(&replay.next_game, 0);
+    atomic_init(&replay.locks, 0);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int started = 0;
+    while (started < threads && pthread_create(&workers[started], nullptr, check_worker, &replay) == 0) {
+        started += 1;
+    }
+    // Wait for the started workers before freeing what they read
+    for (int i = 0; i < started; ++i) {
+        pthread_join(workers[i], nullptr);
+    }
+    if (started < threads) {
+        fprintf(stderr, "ERROR: cannot create thread %d\n", started);
+        free(workers);
+        free(replay.results);
+        free(games);
+        free(data);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    int failures = 0;
+    for (int i = 0; i < count; ++i) {
+        const ReplayResult* result = &replay.results[i];
+        if (result->lock < 0) {
+            continue;
+        }
+        if (failures < REPLAY_SHOWN_FAILURES) {
+            fprintf(stderr, "FAIL game %d (seed %llu, level %d): %s at lock %d\n", i, (unsigned long long)games[i].seed,
+                games[i].start_level, result->reason, result->lock);
+        }
+        failures += 1;
+    }
+
+    printf("%d games, %ld locks replayed in %.3f s on %d threads: ", count, atomic_load(&replay.locks), elapsed, threads);
+    if (failures > 0) {
+        printf("%d games diverged\n", failures);
+    } else {
+        printf("OK\n");
+    }
+
+    free(workers);
+    free(replay.results);
+    free(games);
+    free(data);
+    return failures > 0 ? 1 : 0;
+}
+
+bool record_game(ByteBuffer* out, Ai* ai, uint64_t seed, int index, int max_pieces)
+{
+    // Every start level with every randomizer, 10 and 3 are coprime
+    int start_level = index % 10;
+    Randomizer randomizer = (Randomizer)(index % 3);
+    Rng rng = Rng_seed(seed ^ ((uint64_t)index * 0x9E3779B97F4A7C15ull));
+    uint64_t game_seed = Rng_next(&rng);
+    Game game = Game_init(start_level, game_seed, randomizer);
+
+    ByteBuffer inputs = { 0 };
+    ByteBuffer checks = { 0 };
+    uint8_t input_count = 0;
+    uint8_t pending = 0;
+    uint64_t chain = 0;
+    int locks = 0;
+    bool topped_out = false;
+    bool ok = true;
+
+    while (ok && (ai == nullptr || locks < max_pieces) && !topped_out) {
+        ReplayInput piece_inputs[64];
+        int count = 0;
+
+        // A stray press now and then: into a wall, a rotation undone by the next one
+        if (Rng_next(&rng) % 8 == 0) {
+            piece_inputs[count++] = (ReplayInput)(ReplayLeft + Rng_next(&rng) % 4);
+        }
+
+        Placement placement = { 0 };
+        Game probe = game;
+        for (int i = 0; i < count; ++i) {
+            Replay_step(&probe, piece_inputs[i], start_level);
+        }
+        bool placed = ai != nullptr ? Ai_best_placement(ai, &probe, &placement) : true;
+        if (ai == nullptr) {
+            placement.rotation = (int)(Rng_next(&rng) % 4);
+            placement.column = (int)(Rng_next(&rng) % COLS);
+        }
+        if (placed) {
+            int rotations = count;
+            if (placement.rotation == 3 && Rng_next(&rng) % 2 == 0) {
+                piece_inputs[count++] = ReplayRotateLeft;
+            } else {
+                for (int i = 0; i < placement.rotation; ++i) {
+                    piece_inputs[count++] = ReplayRotateRight;
+                }
+            }
+            for (int i = rotations; i < count; ++i) {
+                Replay_step(&probe, piece_inputs[i], start_level);
+            }
+            for (int i = 0; i < COLS && Piece_left_square(&probe.active_piece) != placement.column; ++i) {
+                piece_inputs[count] = Piece_left_square(&probe.active_piece) > placement.column ? ReplayLeft : ReplayRight;
+                Replay_step(&probe, piece_inputs[count++], start_level);
+            }
+        }
+        // Hard drop or let it fall row by row (soft drop or no input)
+        if (Rng_next(&rng) % 4 != 0) {
+            piece_inputs[count++] = ReplayHardDrop;
+        }
+
+        bool locked = false;
+        for (int i = 0; !locked; ++i) {
+            ReplayInput input = i < count ? piece_inputs[i] : ReplayGravity;
+            locked = Replay_step(&game, input, start_level);
+
+            pending |= (uint8_t)(input << (input_count % 2 * 4));
+            input_count += 1;
+            if (input_count % 2 == 0) {
+                ok = ok && ByteBuffer_append(&inputs, &pending, 1);
+                pending = 0;
+            }
+        }
+
+        uint64_t hash = Replay_hash(&game);
+        ok = ok && ByteBuffer_append_le(&checks, (uint16_t)hash, 2);
+        chain = Replay_chain(chain, hash);
+        locks += 1;
+        topped_out = Game_check_game_over(&game);
+    }
+    if (input_count % 2 != 0) {
+        ok = ok && ByteBuffer_append(&inputs, &pending, 1);
+    }
+
+    uint8_t flags[4] = { (uint8_t)start_level, (uint8_t)randomizer, topped_out, 0 };
+    ok = ok && ByteBuffer_append_le(out, game_seed, 8) && ByteBuffer_append(out, flags, 4) && ByteBuffer_append_le(out, (uint64_t)locks, 4)
+        && ByteBuffer_append_le(out, inputs.size, 4) && ByteBuffer_append_le(out, chain, 8) && ByteBuffer_append(out, checks.data, checks.size)
+        && ByteBuffer_append(out, inputs.data, inputs.size);
+
+    free(inputs.data);
+    free(checks.data);
+    return ok;
+}
+
+int record(const char* path, int games, int top_outs, int max_pieces, uint64_t seed)
+{
+    TranspositionTable table = { 0 };
+    Ai ai = {
+        .lookahead = 1,
+        .table = TranspositionTable_init(&table, TT_LOG2_ENTRIES) ? &table : nullptr,
+    };
+
+    ByteBuffer out = { 0 };
+    bool ok = ByteBuffer_append(&out, REPLAY_MAGIC, 4) && ByteBuffer_append_le(&out, REPLAY_VERSION, 4) && ByteBuffer_append_le(&out, (uint64_t)(games + top_outs), 4);
+    for (int i = 0; ok && i < games + top_outs; ++i) {
+        ok = record_game(&out, i < games ? &ai : nullptr, seed, i, max_pieces);
+    }
+    if (ai.table != nullptr) {
+        TranspositionTable_free(&table);
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        free(out.data);
+        return 1;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr || fwrite(out.data, 1, out.size, file) != out.size) {
+        fprintf(stderr, "ERROR: cannot write %s\n", path);
+        free(out.data);
+        return 1;
+    }
+    fclose(file);
+    printf("%d games recorded in %s (%zu bytes)\n", games + top_outs, path, out.size);
+
+    free(out.data);
+    return 0;
+}
+
+bool ByteBuffer_append(ByteBuffer* buffer, const void* data, size_t size)
+{
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+        while (capacity < buffer->size + size) {
+            capacity *= 2;
+        }
+        uint8_t* grown = realloc(buffer->data, capacity);
+        if (grown == nullptr) {
+            return false;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    if (size > 0) {
+        memcpy(buffer->data + buffer->size, data, size);
+    }
+    buffer->size += size;
+    return true;
+}
+
+bool ByteBuffer_append_le(ByteBuffer* buffer, uint64_t value, int bytes)
+{
+    uint8_t data[8];
+    for (int i = 0; i < bytes; ++i) {
+        data[i] = (uint8_t)(value >> (8 * i));
+    }
+    return ByteBuffer_append(buffer, data, (size_t)bytes);
+}
+
+uint64_t read_le(const uint8_t* data, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= (uint64_t)data[i] << (8 * i);
+    }
+    return value;
+}
+
+bool Batch_step_game(Game* game, Action action, int start_level)
+{
+    switch (action) {
+    case MoveLeft:
+        Game_move_active_piece(game, Left);
+        break;
+    case MoveRight:
+        Game_move_active_piece(game, Right);
+        break;
+    case RotateLeft:
+        Game_rotate_active_piece(game, Left);
+        break;
+    case RotateRight:
+        Game_rotate_active_piece(game, Right);
+        break;
+    case SoftDrop:
+        // Down by one if it can, the soft drop never locks
+        Game_gravity_active_piece(game);
+        break;
+    case HardDrop:
+        Game_hard_drop_active_piece(game);
+        break;
+    default:
+        break;
+    }
+
+    if (!Game_gravity_active_piece(game)) {
+        return false;
+    }
+    Game_lock_active_piece(game, start_level, nullptr);
+    return Game_check_game_over(game);
+}
+
+const char* Batch_compare(const GameBatch* batch, int index, const Game* game, bool over)
+{
+    if (over != (batch->done[index] != 0)) {
+        return "game over";
+    }
+    if (batch->score[index] != game->score || batch->lines[index] != game->destroyed_lines || batch->level[index] != game->current_level) {
+        return "score, lines or level";
+    }
+    for (int row = 0; row < TOTAL_ROWS; ++row) {
+        for (int col = 0; col < COLS; ++col) {
+            if (GameBatch_is_occupied(batch, index, row, col) != game->board[row][col].active) {
+                return "board";
+            }
+        }
+    }
+    if (over) {
+        return nullptr;
+    }
+    if (batch->kind[index] != game->active_piece.kind || batch->next_kind[index] != Game_next_kind(game, 0)) {
+        return "active or next kind";
+    }
+
+    // The batch gives the squares in row major order
+    Square expected[4];
+    memcpy(expected, game->active_piece.squares, sizeof(expected));
+    for (int i = 1; i < 4; ++i) {
+        for (int j = i; j > 0 && (expected[j][0] < expected[j - 1][0] || (expected[j][0] == expected[j - 1][0] && expected[j][1] < expected[j - 1][1])); --j) {
+            Square swap = { expected[j][0], expected[j][1] };
+            memcpy(expected[j], expected[j - 1], sizeof(swap));
+            memcpy(expected[j - 1], swap, sizeof(swap));
+        }
+    }
+    Square squares[4];
+    GameBatch_active_squares(batch, index, squares);
+    if (memcmp(squares, expected, sizeof(squares)) != 0) {
+        return "active piece";
+    }
+    return nullptr;
+}
+
+int batch_check(int steps, int games, uint64_t seed)
+{
+    const Randomizer randomizers[] = { Uniform, Bag, Nes };
+    Rng rng = Rng_seed(seed);
+    uint8_t* actions = malloc((size_t)games);
+    Game* mirrors = malloc(sizeof(Game) * (size_t)games);
+    int* start_levels = malloc(sizeof(int) * (size_t)games);
+    if (actions == nullptr || mirrors == nullptr || start_levels == nullptr) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        free(actions);
+        free(mirrors);
+        free(start_levels);
+        return 1;
+    }
+
+    long locks = 0;
+    int failures = 0;
+    for (int r = 0; r < ARRAY_LEN_INT(randomizers) && failures == 0; ++r) {
+        GameBatch batch;
+        if (!GameBatch_init(&batch, games, randomizers[r])) {
+            fprintf(stderr, "ERROR: out of memory\n");
+            failures = 1;
+            break;
+        }
+
+        for (int step = 0; step <= steps && failures == 0; ++step) {
+            // Both start again together when the game ends (and at the first step)
+            for (int game = 0; game < games; ++game) {
+                if (batch.done[game]) {
+                    uint64_t game_seed = Rng_next(&rng);
+                    start_levels[game] = (int)(Rng_next(&rng) % 10);
+                    GameBatch_reset(&batch, game, start_levels[game], game_seed);
+                    mirrors[game] = Game_init(start_levels[game], game_seed, randomizers[r]);
+                }
+                actions[game] = (uint8_t)(Rng_next(&rng) % ActionCount);
+            }
+            if (step == steps) {
+                break;
+            }
+
+            GameBatch_step(&batch, actions);
+            for (int game = 0; game < games && failures < REPLAY_SHOWN_FAILURES; ++game) {
+                bool over = Batch_step_game(&mirrors[game], (Action)actions[game], start_levels[game]);
+                locks += batch.landed[game];
+                const char* reason = Batch_compare(&batch, game, &mirrors[game], over);
+                if (reason != nullptr) {
+                    fprintf(stderr, "FAIL: randomizer %d, game %d, step %d: %s differs\n", r, game, step, reason);
+                    failures += 1;
+                }
+            }
+        }
+        GameBatch_free(&batch);
+    }
+
+    free(actions);
+    free(mirrors);
+    free(start_levels);
+    if (failures > 0) {
+        return 1;
+    }
+    printf("%d games of every randomizer, %d steps, %ld locks: the batch matches Game\n", games, steps, locks);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+in vec4 fragColor;
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+uniform sampler2D texture0;
+uniform vec2 direction; // one pixel along the axis of the pass
+
+// 9 taps gaussian in 5 fetches: the bilinear filter reads two taps in one, at the offset
+// between them weighted by their weights
+#define OFFSET_1 1.3846153846
+#define OFFSET_2 3.2307692308
+#define WEIGHT_0 0.2270270270
+#define WEIGHT_1 0.3162162162
+#define WEIGHT_2 0.0702702703
+
+void main() {
+    vec3 color = texture(texture0, fragTexCoord).rgb * WEIGHT_0;
+    color += (texture(texture0, fragTexCoord + direction * OFFSET_1).rgb + texture(texture0, fragTexCoord - direction * OFFSET_1).rgb) * WEIGHT_1;
+    color += (texture(texture0, fragTexCoord + direction * OFFSET_2).rgb + texture(texture0, fragTexCoord - direction * OFFSET_2).rgb) * WEIGHT_2;
+
+    finalColor = vec4(color, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 300 es
+
+precision mediump float;
+
+in vec4 fragColor;
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform float threshold;
+
+void main() {
+    vec4 texel = texture(texture0, fragTexCoord) * colDiffuse * fragColor;
+    float brightness = max(texel.r, max(texel.g, texel.b));
+
+    // Only the part over the threshold, keeping the hue
+    float contribution = max(brightness - threshold, 0.0) / max(brightness, 0.0001);
+    finalColor = vec4(texel.rgb * contribution, 1.0);
+}
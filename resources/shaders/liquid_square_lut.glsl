@@ -0,0 +1,35 @@
+#version 330 core
+
+in vec4 fragColor;
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+uniform float time;
+uniform float wave[64]; // sin(x) * 0.5 + 0.5 over one period, uploaded once
+
+#define WAVE_SIZE 64.0
+#define INV_TAU 0.15915494
+
+// sin(x) * 0.5 + 0.5 from the table, linear between the samples
+float wave_at(float x) {
+    float position = fract(x * INV_TAU) * WAVE_SIZE;
+    int i = int(position);
+    return mix(wave[i], wave[(i + 1) & 63], fract(position));
+}
+
+void main() {
+    vec2 grid = fragTexCoord * 20.0;
+    vec2 cell = fract(grid) - 0.5;
+
+    // Same pulse and sparkle of liquid_square.glsl
+    float pulse = wave_at(time * 4.0 + floor(grid.x) + floor(grid.y));
+    float sparkle = (wave_at((grid.x + grid.y) * 10.0 + time * 5.0) - 0.5) * 0.2;
+
+    // smoothstep(0.15, 0.0, distance) without the square root: 1 / 0.15^2 = 44.4
+    float glow = max(1.0 - dot(cell, cell) * 44.4, 0.0) * pulse;
+
+    vec3 baseColor = fragColor.rgb;
+    vec3 color = mix(baseColor, baseColor * (glow + sparkle + 0.5), 0.92);
+
+    finalColor = vec4(color, fragColor.a);
+}
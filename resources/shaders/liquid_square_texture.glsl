@@ -0,0 +1,26 @@
+#version 330 core
+
+in vec4 fragColor;
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+uniform float time;
+uniform sampler2D pattern; // glow, pulse phase and sparkle phase baked at startup
+uniform sampler2D wave; // sin(x) * 0.5 + 0.5 of a turn of x in red, of y in green
+
+// Turns per second of the pulse and of the sparkle: 4 / TAU and 5 / TAU
+#define SPEED vec2(0.63661977, 0.79577472)
+
+void main() {
+    vec3 texel = texture(pattern, fragTexCoord).rgb;
+    vec2 waves = texture(wave, texel.gb + time * SPEED).rg;
+
+    // Same pulse and sparkle of liquid_square.glsl
+    float glow = texel.r * waves.x;
+    float sparkle = (waves.y - 0.5) * 0.2;
+
+    vec3 baseColor = fragColor.rgb;
+    vec3 color = mix(baseColor, baseColor * (glow + sparkle + 0.5), 0.92);
+
+    finalColor = vec4(color, fragColor.a);
+}
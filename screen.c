@@ -0,0 +1,54 @@
+#include <math.h>
+
+#include "screen.h"
+
+void Screen_init(Screen* screen, int width, int height, int internal_height, bool integer_scaling)
+{
+    screen->width = width;
+    screen->height = height;
+    screen->zoom = (float)internal_height / (float)height;
+    screen->integer_scaling = integer_scaling;
+
+    int internal_width = (int)roundf((float)width * screen->zoom);
+    screen->target = LoadRenderTexture(internal_width, internal_height);
+    SetTextureFilter(screen->target.texture, integer_scaling ? TEXTURE_FILTER_POINT : TEXTURE_FILTER_BILINEAR);
+}
+
+void Screen_free(Screen* screen)
+{
+    UnloadRenderTexture(screen->target);
+}
+
+void Screen_begin(const Screen* screen)
+{
+    BeginTextureMode(screen->target);
+    BeginMode2D((Camera2D) { .zoom = screen->zoom });
+}
+
+void Screen_end(const Screen* screen)
+{
+    (void)screen;
+    EndMode2D();
+    EndTextureMode();
+}
+
+void Screen_draw(const Screen* screen)
+{
+    float width = (float)screen->target.texture.width;
+    float height = (float)screen->target.texture.height;
+    float scale = fminf((float)GetScreenWidth() / width, (float)GetScreenHeight() / height);
+    // A window smaller than the internal resolution cannot have a whole multiple
+    if (screen->integer_scaling && scale >= 1.0f) {
+        scale = floorf(scale);
+    }
+
+    Rectangle destination = {
+        .x = floorf(((float)GetScreenWidth() - width * scale) / 2.0f),
+        .y = floorf(((float)GetScreenHeight() - height * scale) / 2.0f),
+        .width = width * scale,
+        .height = height * scale,
+    };
+    ClearBackground(BLACK);
+    // Render textures are upside down
+    DrawTexturePro(screen->target.texture, (Rectangle) { 0.0f, 0.0f, width, -height }, destination, (Vector2) { 0.0f, 0.0f }, 0.0f, WHITE);
+}
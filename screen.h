@@ -0,0 +1,40 @@
+#ifndef SCREEN_H_
+#define SCREEN_H_
+
+#include <raylib.h>
+
+/*
+    The game draws a fixed layout (width * height, in the pixels of SQUARE_SIZE and
+    GUI_SIZE) into a render texture of fixed internal resolution, then the texture is
+    scaled to the window, whatever its size, keeping the aspect ratio with black bars.
+
+    The internal resolution sets the fill cost of every frame: a 4K window costs the same
+    as a small one, only the last stretch is larger.
+    - integer scaling: the largest whole multiple that fits, nearest filtering (sharp)
+    - smooth scaling: fills the window, bilinear filtering
+*/
+
+typedef struct {
+    int width; // of the layout
+    int height;
+    float zoom; // internal resolution / layout
+    bool integer_scaling;
+    RenderTexture2D target;
+} Screen;
+
+/*
+    internal_height is the height of the render texture, the width follows the layout
+*/
+void Screen_init(Screen* screen, int width, int height, int internal_height, bool integer_scaling);
+void Screen_free(Screen* screen);
+
+/*
+    Between Screen_begin and Screen_end everything is drawn in the coordinates of the layout
+    into the render texture. Screen_draw then stretches it to the window, inside
+    BeginDrawing
+*/
+void Screen_begin(const Screen* screen);
+void Screen_end(const Screen* screen);
+void Screen_draw(const Screen* screen);
+
+#endif // SCREEN_H_
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sfx.h"
+
+/*
+    The raylib callback has no user pointer: it mixes the mixer started by SfxMixer_init
+*/
+SfxMixer* sfx_mixer = nullptr;
+
+/*
+    Audio thread: start the queued clips and mix the voices into buffer
+*/
+void SfxMixer_callback(void* buffer, unsigned int frames);
+
+/*
+    Audio thread: take a voice for clip, stealing the one that played the longest
+*/
+void SfxMixer_start_voice(SfxMixer* mixer, int clip);
+
+bool SfxMixer_init(SfxMixer* mixer, const char* paths[SfxCount], int buffer_frames)
+{
+    memset(mixer, 0, sizeof(*mixer));
+    for (int i = 0; i < SFX_VOICES; ++i) {
+        mixer->voices[i].clip = -1;
+    }
+
+    Wave waves[SfxCount];
+    int total = 0;
+    for (int i = 0; i < SfxCount; ++i) {
+        waves[i] = LoadWave(paths[i]);
+        if (waves[i].data != nullptr) {
+            WaveFormat(&waves[i], SFX_SAMPLE_RATE, 16, SFX_CHANNELS);
+        }
+        mixer->clips[i] = (SfxClip) { .offset = total, .frames = waves[i].data != nullptr ? (int)waves[i].frameCount : 0 };
+        total += mixer->clips[i].frames;
+    }
+
+    mixer->pcm = malloc((size_t)(total > 0 ? total : 1) * SFX_CHANNELS * sizeof(int16_t));
+    for (int i = 0; i < SfxCount; ++i) {
+        if (mixer->pcm != nullptr && mixer->clips[i].frames > 0) {
+            memcpy(mixer->pcm + (size_t)mixer->clips[i].offset * SFX_CHANNELS, waves[i].data, (size_t)mixer->clips[i].frames * SFX_CHANNELS * sizeof(int16_t));
+        }
+        UnloadWave(waves[i]);
+    }
+    if (mixer->pcm == nullptr) {
+        return false;
+    }
+
+    SetAudioStreamBufferSizeDefault(buffer_frames);
+    mixer->stream = LoadAudioStream(SFX_SAMPLE_RATE, 16, SFX_CHANNELS);
+    // Back to the raylib default for the other streams
+    SetAudioStreamBufferSizeDefault(0);
+    if (!IsAudioStreamValid(mixer->stream)) {
+        free(mixer->pcm);
+        mixer->pcm = nullptr;
+        return false;
+    }
+
+    sfx_mixer = mixer;
+    SetAudioStreamCallback(mixer->stream, SfxMixer_callback);
+    PlayAudioStream(mixer->stream);
+    return true;
+}
+
+void SfxMixer_free(SfxMixer* mixer)
+{
+    if (mixer->pcm == nullptr) {
+        return;
+    }
+    StopAudioStream(mixer->stream);
+    UnloadAudioStream(mixer->stream);
+    sfx_mixer = nullptr;
+    free(mixer->pcm);
+    mixer->pcm = nullptr;
+}
+
+void SfxMixer_play(SfxMixer* mixer, SfxId clip)
+{
+    uint32_t head = atomic_load_explicit(&mixer->queue_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&mixer->queue_tail, memory_order_acquire);
+    if (mixer->pcm == nullptr || head - tail == SFX_QUEUE) {
+        return;
+    }
+    mixer->queue[head & (SFX_QUEUE - 1)] = (uint8_t)clip;
+    atomic_store_explicit(&mixer->queue_head, head + 1, memory_order_release);
+}
+
+void SfxMixer_start_voice(SfxMixer* mixer, int clip)
+{
+    int chosen = 0;
+    for (int i = 0; i < SFX_VOICES; ++i) {
+        if (mixer->voices[i].clip < 0) {
+            chosen = i;
+            break;
+        }
+        if (mixer->voices[i].position > mixer->voices[chosen].position) {
+            chosen = i;
+        }
+    }
+    mixer->voices[chosen] = (SfxVoice) { .clip = clip, .position = 0 };
+}
+
+void SfxMixer_callback(void* buffer, unsigned int frames)
+{
+    SfxMixer* mixer = sfx_mixer;
+    int16_t* out = buffer;
+    if (mixer == nullptr) {
+        memset(out, 0, (size_t)frames * SFX_CHANNELS * sizeof(int16_t));
+        return;
+    }
+
+    uint32_t tail = atomic_load_explicit(&mixer->queue_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&mixer->queue_head, memory_order_acquire);
+    for (; tail != head; ++tail) {
+        SfxMixer_start_voice(mixer, mixer->queue[tail & (SFX_QUEUE - 1)]);
+    }
+    atomic_store_explicit(&mixer->queue_tail, tail, memory_order_release);
+
+    // Sum in 32 bits and clip once
+    int32_t mix[SFX_BUFFER_FRAMES * SFX_CHANNELS];
+    for (unsigned int first = 0; first < frames; first += SFX_BUFFER_FRAMES) {
+        int count = frames - first < SFX_BUFFER_FRAMES ? (int)(frames - first) : SFX_BUFFER_FRAMES;
+        memset(mix, 0, (size_t)count * SFX_CHANNELS * sizeof(int32_t));
+
+        for (int v = 0; v < SFX_VOICES; ++v) {
+            SfxVoice* voice = &mixer->voices[v];
+            if (voice->clip < 0) {
+                continue;
+            }
+            const SfxClip* clip = &mixer->clips[voice->clip];
+            int playing = clip->frames - voice->position < count ? clip->frames - voice->position : count;
+            const int16_t* pcm = mixer->pcm + (size_t)(clip->offset + voice->position) * SFX_CHANNELS;
+            for (int i = 0; i < playing * SFX_CHANNELS; ++i) {
+                mix[i] += pcm[i];
+            }
+
+            voice->position += playing;
+            if (voice->position >= clip->frames) {
+                voice->clip = -1;
+            }
+        }
+
+        int16_t* chunk = out + (size_t)first * SFX_CHANNELS;
+        for (int i = 0; i < count * SFX_CHANNELS; ++i) {
+            chunk[i] = (int16_t)(mix[i] > INT16_MAX ? INT16_MAX : mix[i] < INT16_MIN ? INT16_MIN : mix[i]);
+        }
+    }
+}
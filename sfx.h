@@ -0,0 +1,67 @@
+#ifndef SFX_H_
+#define SFX_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include <raylib.h>
+
+/*
+    Mixer for the sound effects. All the clips are decoded once into a single PCM arena
+    and mixed by the callback of one audio stream into a fixed pool of voices, so the
+    same effect can play over itself (two quick clears do not cut each other) and playing
+    never allocates or decodes.
+
+    The game only pushes the clip to play in a lock free queue, the voices belong to the
+    audio thread. When all the voices are busy the oldest one is stolen.
+*/
+
+#define SFX_SAMPLE_RATE 48000
+#define SFX_CHANNELS 2
+#define SFX_VOICES 16
+#define SFX_QUEUE 32 // power of 2
+// Frames of the stream buffer: small means low latency (256 frames are 5.3 ms)
+#define SFX_BUFFER_FRAMES 256
+
+typedef enum {
+    SfxLineClear,
+    SfxTetris,
+    SfxNextLevel,
+    SfxCount
+} SfxId;
+
+typedef struct {
+    int offset; // first frame in the arena
+    int frames;
+} SfxClip;
+
+typedef struct {
+    int clip; // -1 if the voice is free
+    int position; // next frame to play
+} SfxVoice;
+
+typedef struct {
+    int16_t* pcm; // interleaved SFX_CHANNELS frames of all the clips
+    SfxClip clips[SfxCount];
+    SfxVoice voices[SFX_VOICES];
+
+    uint8_t queue[SFX_QUEUE];
+    _Atomic uint32_t queue_head; // written by the game
+    _Atomic uint32_t queue_tail; // written by the audio thread
+
+    AudioStream stream;
+} SfxMixer;
+
+/*
+    Decode paths[SfxCount] (a missing file is a silent clip) and start the stream with
+    buffer_frames per buffer. Call it after InitAudioDevice. Only one mixer can exist
+*/
+bool SfxMixer_init(SfxMixer* mixer, const char* paths[SfxCount], int buffer_frames);
+void SfxMixer_free(SfxMixer* mixer);
+
+/*
+    Start the clip on a free voice, from the game thread. Dropped if the queue is full
+*/
+void SfxMixer_play(SfxMixer* mixer, SfxId clip);
+
+#endif // SFX_H_
@@ -0,0 +1,437 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ai.h"
+#include "game.h"
+#include "metrics.h"
+
+/*
+    cetris-tournament: play a lot of complete AI games on every core and print the
+    aggregated statistics. Every game is seeded by (seed, game index), so the results do
+    not depend on the number of threads or on the scheduling.
+*/
+
+#define MAX_START_LEVELS 10
+#define HISTOGRAM_BUCKETS 20
+#define TT_LOG2_ENTRIES 16
+
+typedef struct {
+    int games;
+    int threads;
+    int start_levels[MAX_START_LEVELS];
+    int start_levels_count;
+    Randomizer randomizer;
+    int lookahead;
+    int max_pieces;
+    uint64_t seed;
+    const char* output_path;
+    const char* csv_path;
+} TournamentConfig;
+
+typedef struct {
+    const TournamentConfig* config;
+    GameResult* results;
+    atomic_int next_game;
+} Tournament;
+
+/*
+    Summary of a distribution of values
+*/
+typedef struct {
+    double mean;
+    double stddev;
+    int min;
+    int p10;
+    int p50;
+    int p90;
+    int max;
+} Distribution;
+
+void usage(const char* program);
+bool parse_args(int argc, char** argv, TournamentConfig* config);
+const char* Randomizer_name(Randomizer randomizer);
+
+/*
+    Play a whole game with the AI until it tops out or places max_pieces pieces
+*/
+GameResult play_game(const TournamentConfig* config, Ai* ai, int index);
+
+/*
+    Worker thread: take the next game index until there are no more games
+*/
+void* worker(void* arg);
+
+Distribution Distribution_compute(int* values, int count);
+void Distribution_print(FILE* out, const char* name, Distribution distribution);
+int compare_int(const void* a, const void* b);
+void write_report(FILE* out, const TournamentConfig* config, const GameResult* results, double elapsed);
+bool write_csv(const char* path, const GameResult* results, int count);
+
+int main(int argc, char** argv)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    TournamentConfig config = {
+        .games = 1000,
+        .threads = cores > 0 ? (int)cores : 1,
+        .start_levels = { 0 },
+        .start_levels_count = 1,
+        .randomizer = Uniform,
+        .lookahead = 1,
+        .max_pieces = 5000,
+        .seed = (uint64_t)time(NULL),
+        .output_path = nullptr,
+        .csv_path = nullptr,
+    };
+    if (!parse_args(argc, argv, &config)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Tournament tournament = {
+        .config = &config,
+        .results = calloc((size_t)config.games, sizeof(GameResult)),
+    };
+    pthread_t* threads = calloc((size_t)config.threads, sizeof(pthread_t));
+    if (tournament.results == nullptr || threads == nullptr) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return 1;
+    }
+    atomic_init(&tournament.next_game, 0);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int i = 0; i < config.threads; ++i) {
+        if (pthread_create(&threads[i], nullptr, worker, &tournament) != 0) {
+            fprintf(stderr, "ERROR: cannot create thread %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < config.threads; ++i) {
+        pthread_join(threads[i], nullptr);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    FILE* out = stdout;
+    if (config.output_path != nullptr) {
+        out = fopen(config.output_path, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "ERROR: cannot open %s\n", config.output_path);
+            return 1;
+        }
+    }
+    write_report(out, &config, tournament.results, elapsed);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    if (config.csv_path != nullptr && !write_csv(config.csv_path, tournament.results, config.games)) {
+        fprintf(stderr, "ERROR: cannot write %s\n", config.csv_path);
+        return 1;
+    }
+
+    free(threads);
+    free(tournament.results);
+    return 0;
+}
+
+//              //
+//              //
+//  FUNCTIONS   //
+//              //
+//              //
+
+void usage(const char* program)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -g <games>        number of games (default 1000)\n"
+        "  -j <threads>      worker threads (default: all cores)\n"
+        "  -l <levels>       comma separated start levels 0-9, games are split between them (default 0)\n"
+        "  -r <randomizer>   uniform|bag|nes (default uniform)\n"
+        "  -d <lookahead>    pieces the AI looks ahead, 1 or 2 (default 1)\n"
+        "  -m <pieces>       stop a game after this many pieces (default 5000)\n"
+        "  -s <seed>         base seed (default: time)\n"
+        "  -o <file>         write the report to file instead of stdout\n"
+        "  -c <file>         write every game result as csv\n",
+        program);
+}
+
+bool parse_args(int argc, char** argv, TournamentConfig* config)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 'g':
+            config->games = atoi(value);
+            break;
+        case 'j':
+            config->threads = atoi(value);
+            break;
+        case 'l': {
+            config->start_levels_count = 0;
+            char* end = (char*)value;
+            while (*end != '\0' && config->start_levels_count < MAX_START_LEVELS) {
+                long level = strtol(end, &end, 10);
+                if (level < 0 || level > 9) {
+                    return false;
+                }
+                config->start_levels[config->start_levels_count++] = (int)level;
+                if (*end == ',') {
+                    end += 1;
+                } else if (*end != '\0') {
+                    return false;
+                }
+            }
+            break;
+        }
+        case 'r':
+            if (strcmp(value, "uniform") == 0) {
+                config->randomizer = Uniform;
+            } else if (strcmp(value, "bag") == 0) {
+                config->randomizer = Bag;
+            } else if (strcmp(value, "nes") == 0) {
+                config->randomizer = Nes;
+            } else {
+                return false;
+            }
+            break;
+        case 'd':
+            config->lookahead = atoi(value);
+            break;
+        case 'm':
+            config->max_pieces = atoi(value);
+            break;
+        case 's':
+            config->seed = strtoull(value, nullptr, 10);
+            break;
+        case 'o':
+            config->output_path = value;
+            break;
+        case 'c':
+            config->csv_path = value;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return config->games > 0 && config->threads > 0 && config->start_levels_count > 0
+        && config->lookahead >= 1 && config->lookahead <= 2 && config->max_pieces > 0;
+}
+
+const char* Randomizer_name(Randomizer randomizer)
+{
+    switch (randomizer) {
+    case Uniform:
+        return "uniform";
+    case Bag:
+        return "bag";
+    case Nes:
+        return "nes";
+    }
+    return "?";
+}
+
+GameResult play_game(const TournamentConfig* config, Ai* ai, int index)
+{
+    int start_level = config->start_levels[index % config->start_levels_count];
+    Rng seeder = Rng_seed(config->seed ^ ((uint64_t)index * 0x9E3779B97F4A7C15ull));
+    Game game = Game_init(start_level, Rng_next(&seeder), config->randomizer);
+    GameResult result = { .start_level = start_level };
+
+    while (result.pieces < config->max_pieces) {
+        Placement placement = { 0 };
+        if (!Ai_best_placement(ai, &game, &placement) || !Game_place_active_piece(&game, placement.rotation, placement.column)) {
+            result.topped_out = true;
+            break;
+        }
+
+        int deleted_rows = Game_lock_active_piece(&game, start_level, nullptr);
+        result.pieces += 1;
+        result.tetrises += deleted_rows == 4;
+
+        if (Game_check_game_over(&game)) {
+            result.topped_out = true;
+            break;
+        }
+    }
+
+    result.score = game.score;
+    result.lines = game.destroyed_lines;
+    result.level = game.current_level;
+    return result;
+}
+
+void* worker(void* arg)
+{
+    Tournament* tournament = arg;
+    TranspositionTable table = { 0 };
+    Ai ai = {
+        .lookahead = tournament->config->lookahead,
+        .table = TranspositionTable_init(&table, TT_LOG2_ENTRIES) ? &table : nullptr,
+    };
+
+    for (;;) {
+        int index = atomic_fetch_add_explicit(&tournament->next_game, 1, memory_order_relaxed);
+        if (index >= tournament->config->games) {
+            break;
+        }
+        tournament->results[index] = play_game(tournament->config, &ai, index);
+    }
+
+    TranspositionTable_free(&table);
+    return nullptr;
+}
+
+int compare_int(const void* a, const void* b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+Distribution Distribution_compute(int* values, int count)
+{
+    qsort(values, (size_t)count, sizeof(int), compare_int);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        sum += values[i];
+    }
+    double mean = sum / count;
+    double variance = 0.0;
+    for (int i = 0; i < count; ++i) {
+        variance += (values[i] - mean) * (values[i] - mean);
+    }
+
+    return (Distribution) {
+        .mean = mean,
+        .stddev = sqrt(variance / count),
+        .min = values[0],
+        .p10 = values[count / 10],
+        .p50 = values[count / 2],
+        .p90 = values[(count * 9) / 10],
+        .max = values[count - 1],
+    };
+}
+
+void Distribution_print(FILE* out, const char* name, Distribution distribution)
+{
+    fprintf(out, "%-8s mean %10.1f  stddev %10.1f  min %8d  p10 %8d  p50 %8d  p90 %8d  max %8d\n",
+        name, distribution.mean, distribution.stddev, distribution.min,
+        distribution.p10, distribution.p50, distribution.p90, distribution.max);
+}
+
+void write_report(FILE* out, const TournamentConfig* config, const GameResult* results, double elapsed)
+{
+    int count = config->games;
+    int* values = malloc((size_t)count * sizeof(int));
+    if (values == nullptr) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return;
+    }
+
+    long long total_pieces = 0;
+    long long total_lines = 0;
+    long long total_tetrises = 0;
+    int topped_out = 0;
+    for (int i = 0; i < count; ++i) {
+        total_pieces += results[i].pieces;
+        total_lines += results[i].lines;
+        total_tetrises += results[i].tetrises;
+        topped_out += results[i].topped_out;
+    }
+
+    fprintf(out, "games      %d (threads %d, randomizer %s, lookahead %d, max pieces %d, seed %llu)\n",
+        count, config->threads, Randomizer_name(config->randomizer), config->lookahead,
+        config->max_pieces, (unsigned long long)config->seed);
+    fprintf(out, "elapsed    %.3f s, %.1f games/s, %.0f pieces/s\n",
+        elapsed, count / elapsed, (double)total_pieces / elapsed);
+    fprintf(out, "topped out %d games (%.1f%%), the others reached the max pieces\n",
+        topped_out, 100.0 * topped_out / count);
+    fprintf(out, "tetrises   %lld, tetris rate %.1f%% of the cleared lines\n",
+        total_tetrises, total_lines > 0 ? 400.0 * (double)total_tetrises / (double)total_lines : 0.0);
+
+    for (int i = 0; i < count; ++i) {
+        values[i] = results[i].score;
+    }
+    Distribution_print(out, "score", Distribution_compute(values, count));
+    for (int i = 0; i < count; ++i) {
+        values[i] = results[i].lines;
+    }
+    Distribution_print(out, "lines", Distribution_compute(values, count));
+    for (int i = 0; i < count; ++i) {
+        values[i] = results[i].pieces;
+    }
+    Distribution pieces = Distribution_compute(values, count);
+    Distribution_print(out, "pieces", pieces);
+
+    // Game length histogram, values is still sorted by pieces
+    fprintf(out, "\ngame length (pieces)\n");
+    int bucket_size = pieces.max / HISTOGRAM_BUCKETS + 1;
+    int max_bucket = 0;
+    int buckets[HISTOGRAM_BUCKETS] = { 0 };
+    for (int i = 0; i < count; ++i) {
+        int bucket = values[i] / bucket_size;
+        buckets[bucket] += 1;
+        if (buckets[bucket] > max_bucket) {
+            max_bucket = buckets[bucket];
+        }
+    }
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        int bar = max_bucket > 0 ? (buckets[i] * 50 + max_bucket - 1) / max_bucket : 0;
+        fprintf(out, "  [%7d, %7d) %7d %.*s\n", i * bucket_size, (i + 1) * bucket_size, buckets[i],
+            bar, "##################################################");
+    }
+
+    if (config->start_levels_count > 1) {
+        fprintf(out, "\nper start level\n");
+        for (int l = 0; l < config->start_levels_count; ++l) {
+            int games = 0;
+            double score = 0.0, lines = 0.0;
+            for (int i = 0; i < count; ++i) {
+                if (i % config->start_levels_count == l) {
+                    games += 1;
+                    score += results[i].score;
+                    lines += results[i].lines;
+                }
+            }
+            fprintf(out, "  level %d: %6d games, mean score %10.1f, mean lines %8.1f\n",
+                config->start_levels[l], games, games > 0 ? score / games : 0.0, games > 0 ? lines / games : 0.0);
+        }
+    }
+
+    free(values);
+}
+
+bool write_csv(const char* path, const GameResult* results, int count)
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    GameResult_write_csv_header(file);
+    fputc('\n', file);
+    for (int i = 0; i < count; ++i) {
+        GameResult_write_csv_columns(file, i, &results[i]);
+        fputc('\n', file);
+    }
+
+    return fclose(file) == 0;
+}